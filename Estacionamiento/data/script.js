@@ -20,12 +20,17 @@ function actualizarParametros() {
     fetch("/api/getParams").then(r=>r.json()).then(d=>{
       document.getElementById("delaySalida").value=d.SALIDA_DELAY_MS;
       document.getElementById("timeoutUltrasonico").value=d.ULTRASONIC_TIMEOUT_MS;
+      document.getElementById("autoTune").checked=d.AUTO_TUNE;
+      if(d.learned){
+        let s=d.learned.SALIDA_DELAY_MS,u=d.learned.ULTRASONIC_TIMEOUT_MS;
+        document.getElementById("aprendido").innerText="Aprendido (p"+d.learned.percentile+"): salida "+s.value+" ms ("+Math.round(s.confidence*100)+"%), timeout "+u.value+" ms ("+Math.round(u.confidence*100)+"%)";
+      }
     }).catch(e=>console.error("Error:",e));
   }
 }
 
 function guardarParametros() {
-  let p={SALIDA_DELAY_MS:parseInt(document.getElementById("delaySalida").value),ULTRASONIC_TIMEOUT_MS:parseInt(document.getElementById("timeoutUltrasonico").value)};
+  let p={SALIDA_DELAY_MS:parseInt(document.getElementById("delaySalida").value),ULTRASONIC_TIMEOUT_MS:parseInt(document.getElementById("timeoutUltrasonico").value),AUTO_TUNE:document.getElementById("autoTune").checked};
   fetch("/api/setParams",{method:"POST",headers:{"Content-Type":"application/json"},body:JSON.stringify(p)}).then(()=>{alert("Guardado");enfoque=false;actualizarParametros();}).catch(e=>console.error("Error:",e));
 }
 
@@ -33,5 +38,7 @@ document.getElementById("delaySalida").addEventListener("focus",()=>{enfoque=tru
 document.getElementById("delaySalida").addEventListener("blur",()=>{enfoque=false;});
 document.getElementById("timeoutUltrasonico").addEventListener("focus",()=>{enfoque=true;});
 document.getElementById("timeoutUltrasonico").addEventListener("blur",()=>{enfoque=false;});
+document.getElementById("autoTune").addEventListener("focus",()=>{enfoque=true;});
+document.getElementById("autoTune").addEventListener("blur",()=>{enfoque=false;});
 setInterval(()=>{actualizarEstado();actualizarParametros();},1000);
 actualizarEstado();actualizarParametros();
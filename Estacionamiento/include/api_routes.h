@@ -0,0 +1,71 @@
+// =====================================================================
+// RUTAS DE LA API (independientes del servidor HTTP)
+// =====================================================================
+//
+// Arman la respuesta JSON de cada endpoint a partir del controlador.
+// El WebServer del ESP32 (main.cpp) y el servidor de loopback del
+// simulador (src/native/) llaman a las mismas funciones, así el
+// benchmark de la PC mide el mismo código que corre en la placa.
+// Cada función devuelve el código HTTP y escribe el cuerpo en `out`.
+
+#ifndef API_ROUTES_H
+#define API_ROUTES_H
+
+#include <stddef.h>
+
+#include "parking_controller.h"
+#include "latency_histogram.h"
+#include "loop_watchdog.h"
+#include "memory_diag.h"
+
+// Tamaño máximo del cuerpo de una respuesta JSON de la API. getStatus
+// incluye una entrada por carril (~190 bytes con contadores de 32 bits),
+// así que crece con LANE_MAX; una respuesta que no cabe devuelve 500
+#define API_RESPONSE_MAX (512 + LANE_MAX * 192)
+// /api/diag y /api/memory: migas de pan, pilas y tablas por endpoint
+#define API_DIAG_RESPONSE_MAX 2048
+
+// Documentos JSON cuyo uso se mide (pico de memoryUsage() por documento)
+enum ApiJsonDoc : uint8_t
+{
+	JSON_DOC_STATUS,
+	JSON_DOC_PARAMS,
+	JSON_DOC_SET_PARAMS,
+	JSON_DOC_LOOP_STATS,
+	JSON_DOC_DIAG,
+	JSON_DOC_MEMORY,
+	JSON_DOC_CONFIG_FILE,
+	JSON_DOC_RFID,
+	JSON_DOC_EVENTS,
+	JSON_DOC_COUNT
+};
+
+struct ApiJsonUsage
+{
+	uint32_t capacity;
+	uint32_t peak;
+};
+
+// Anotar cuánto usó un documento; main.cpp lo usa para config.json
+void api_recordJsonUsage(uint8_t docId, size_t used, size_t capacity);
+const ApiJsonUsage &api_jsonUsage(uint8_t docId);
+
+// GET /api/getStatus
+int api_getStatus(ParkingController &controller, char *out, size_t len);
+// GET /api/getParams
+int api_getParams(ParkingController &controller, char *out, size_t len);
+// POST /api/setParams (el llamador persiste los parámetros si devuelve 200)
+int api_setParams(ParkingController &controller, const char *body, char *out, size_t len);
+// GET /api/loopStats: latencia del lazo de control; reset = empezar ventana nueva
+int api_getLoopStats(LatencyHistogram &loopStats, bool reset, char *out, size_t len);
+// GET /api/diag: etapa actual, bloqueos por etapa y lo que dejó el arranque anterior
+int api_getDiag(const LoopWatchdog &watchdog, uint32_t nowMs, const char *resetReason, char *out, size_t len);
+// GET /api/memory: heap, pilas por tarea, pico de cada documento JSON y nivel de memoria
+int api_getMemory(const MemoryDiag &memory, char *out, size_t len);
+// GET /api/rfid: por lector, tasa de consulta, tiempo de bus, espera de turno y latencia de lectura
+int api_getRfid(const ParkingController &controller, uint32_t nowMs, char *out, size_t len);
+// GET /api/events?since=<seq>: eventos posteriores a seq con su millis() y su espera
+// hasta esta respuesta (máximo EVENT_RESPONSE_MAX; "more" indica que quedan)
+int api_getEvents(const ParkingController &controller, uint32_t sinceSeq, uint32_t nowMs, char *out, size_t len);
+
+#endif // API_ROUTES_H
@@ -0,0 +1,71 @@
+// =====================================================================
+// AUTO-AJUSTE DE TIEMPOS A PARTIR DEL TRÁFICO OBSERVADO
+// =====================================================================
+//
+// Aprende dos tiempos de la pluma de entrada con cuantiles en streaming
+// (P²) y propone valores para los parámetros configurables:
+// - aproximación (pluma abierta -> auto detectado) -> ULTRASONIC_TIMEOUT_MS
+// - paso (auto detectado -> auto ya pasó)           -> SALIDA_DELAY_MS
+// La pluma de salida no tiene sensor, así que el tiempo de paso de la
+// entrada se usa como referencia de cuánto tarda un auto bajo la pluma.
+// Cada valor = percentil AUTOTUNE_PERCENTILE + AUTOTUNE_MARGIN_PCT %,
+// recortado a los límites de seguridad de config.h.
+// Un timeout sin auto solo dice "tardó más que el timeout vigente": esa
+// muestra censurada no entra al cuantil (si no, el margen lo haría subir
+// en cada timeout hasta el máximo); se cuenta aparte.
+
+#ifndef AUTO_TUNER_H
+#define AUTO_TUNER_H
+
+#include <stdint.h>
+
+#include "config.h"
+#include "p2_quantile.h"
+
+// Un parámetro aprendido: cuantil observado y límites de seguridad
+class LearnedParam
+{
+public:
+	LearnedParam(int minMs, int maxMs);
+
+	void add(uint32_t ms) { quantile.add((float)ms); }
+	// Observación censurada (no se midió el tiempo): solo se cuenta
+	void addCensored() { censoredCount++; }
+	void reset()
+	{
+		quantile.reset();
+		censoredCount = 0;
+	}
+
+	uint32_t samples() const { return quantile.count(); }
+	uint32_t censored() const { return censoredCount; }
+	// Percentil observado (ms), sin margen ni límites
+	uint32_t quantileMs() const { return (uint32_t)(quantile.value() + 0.5f); }
+	// Valor propuesto (ms): percentil + margen, dentro de [minMs, maxMs]
+	int valueMs() const;
+	// Suficientes muestras para aplicarlo
+	bool ready() const { return samples() >= AUTOTUNE_MIN_SAMPLES; }
+	// 0..1 según la cantidad de muestras
+	float confidence() const;
+
+private:
+	P2Quantile quantile;
+	uint32_t censoredCount = 0;
+	int minMs;
+	int maxMs;
+};
+
+class AutoTuner
+{
+public:
+	LearnedParam approach{AUTOTUNE_TIMEOUT_MIN_MS, AUTOTUNE_TIMEOUT_MAX_MS};
+	LearnedParam passage{AUTOTUNE_EXIT_MIN_MS, AUTOTUNE_EXIT_MAX_MS};
+
+	void reset()
+	{
+		approach.reset();
+		passage.reset();
+	}
+};
+
+#endif // AUTO_TUNER_H
@@ -48,17 +48,26 @@
 #define DISPLAY_MESSAGE_MS 3000
 #define SUCCESS_MESSAGE_MS 3000
 
-// Tiempo mínimo entre lecturas RFID (evita duplicados)
+// Tiempo mínimo entre lecturas RFID (evita duplicados); cada lector se
+// consulta con este periodo mientras no haya una tarjeta en curso
 #define RFID_COOLDOWN 2000
 
-// Intervalo de chequeo del sensor ultrasónico
+// Intervalo de chequeo del sensor ultrasónico (ms)
+// Muestreo adaptativo: rápido con un vehículo cerca, lento en reposo
 #define ULTRASONIC_CHECK_INTERVAL 100
+#define ULTRASONIC_FAST_INTERVAL 50
+#define ULTRASONIC_SLOW_INTERVAL 200
 
 // Timeout para que el ultrasónico espere que aparezca un auto (ms)
 #define ULTRASONIC_TIMEOUT_MS 5000
 
 // Tiempo de espera antes de bajar la barrera tras detectar que el auto se fue (ms)
-#define LOWER_BARRIER_WAIT_MS 3000
+// Ya no cubre el recorrido del servo: eso lo informa el evento "cerrada"
+#define LOWER_BARRIER_WAIT_MS 1000
+
+// Tiempo que tiene un auto que ya pasó la pluma para presionar el switch
+// de un cajón; después su reserva vence y el lugar vuelve a estar libre (ms)
+#define PARK_RESERVATION_TIMEOUT_MS 300000
 
 // Timeout máximo en microsegundos para pulseIn() del ultrasonico
 #define ULTRASONIC_PULSE_TIMEOUT_US 30000
@@ -73,7 +82,41 @@
 // Si distancia < THRESHOLD: hay algo bloqueando (auto presente)
 // Si distancia >= THRESHOLD: camino libre (auto pasó o no hay auto)
 #define ULTRASONIC_THRESHOLD 30
-#define ULTRASONIC_FACTOR 0.0343
+
+// Conversión entera de microsegundos de eco a milímetros: mm = us * NUM / DEN
+// (0.343 mm/us ida y vuelta -> 343 / 2000)
+#define ULTRASONIC_MM_NUM 343
+#define ULTRASONIC_MM_DEN 2000
+
+// Rango válido de lectura en mm (fuera de esto se descarta el eco)
+#define ULTRASONIC_MIN_MM 20
+#define ULTRASONIC_MAX_MM 4000
+
+// Filtro: mediana de N ecos (impar, máximo 9) seguida de EMA
+// ALPHA en Q8: 256 = sin suavizado, 64 = 0.25
+#define ULTRASONIC_MEDIAN_N 5
+#define ULTRASONIC_EMA_ALPHA_Q8 128
+
+// Histéresis en mm: se considera auto presente al bajar de ENTER
+// y libre al superar EXIT
+#define ULTRASONIC_ENTER_MM (ULTRASONIC_THRESHOLD * 10)
+#define ULTRASONIC_EXIT_MM (ULTRASONIC_ENTER_MM + 50)
+
+// Debajo de esta distancia filtrada se usa el muestreo rápido
+#define ULTRASONIC_NEAR_MM 1000
+
+// ==================== HISTORIAL DE DISTANCIA ====================
+
+// Capacidad de cada anillo del historial (/api/history)
+// RAW: ~1 minuto a 10 lecturas/s
+#define HISTORY_RAW_CAPACITY 600
+// Buckets de 1 segundo: 5 minutos
+#define HISTORY_1S_CAPACITY 300
+// Buckets de 1 minuto: 2 horas
+#define HISTORY_1M_CAPACITY 120
+
+// Registros por chunk al transmitir /api/history
+#define HISTORY_CHUNK_RECORDS 32
 
 // ==================== CONFIGURACIÓN DEL SERVOMOTOR ====================
 
@@ -83,8 +126,18 @@
 // Ángulo cuando la barra está ARRIBA (abierta)
 #define SERVO_ANGLE_UP 90
 
-// Tiempo de transición del servo en ms
-#define SERVO_TRANSITION_TIME 500
+// Perfil trapezoidal del movimiento de la pluma
+#define SERVO_SPEED_DEG_S 180
+#define SERVO_ACCEL_DEG_S2 720
+
+// PWM por hardware (LEDC) y periodo del timer que recalcula la trayectoria
+#define SERVO_PWM_FREQ 50
+#define SERVO_PWM_BITS 16
+#define SERVO_MIN_PULSE_US 544
+#define SERVO_MAX_PULSE_US 2400
+#define SERVO_TICK_MS 10
+#define SERVO_ENTRY_LEDC_CHANNEL 0
+#define SERVO_EXIT_LEDC_CHANNEL 1
 
 // Invertir mecánicamente el servo de salida?
 // Si tu servo de salida está montado en sentido inverso respecto al de entrada,
@@ -93,9 +146,94 @@
 
 // ==================== CONFIGURACIÓN DE LA SECUENCIA DE SALIDA ====================
 
-// Tiempo para levantar y bajar la barra de salida en ms
-#define EXIT_RAISE_MS 3000
-#define EXIT_LOWER_MS 3000
+// Tiempo que la pluma de salida queda abierta (ms) una vez arriba
+// (valor por defecto de SALIDA_DELAY_MS)
+#define EXIT_HOLD_MS 3000
+
+// ==================== CONFIGURACIÓN DE CARRILES ====================
+
+// Cada carril es una pluma con su propio servo, máquina de estados y
+// temporizadores. Los de entrada llevan además ultrasónico y lector RFID.
+// Campos: tipo, nombre, pin del servo, canal LEDC, servo invertido,
+// TRIG, ECHO, SS del lector (LANE_NO_PIN = el carril no lo tiene)
+#define LANE_NO_PIN 0xFF
+// SS del lector de la pluma de salida (comparte SPI y RST con el de entrada).
+// Con LANE_NO_PIN la salida abre al liberarse un cajón; con un lector, solo
+// con la tarjeta de un auto que entró (sesión abierta en la entrada)
+#define RFID_EXIT_SS_PIN LANE_NO_PIN
+#define LANE_COUNT 2
+#define LANE_TABLE                                                                                                   \
+	{                                                                                                                \
+		{LANE_ENTRY, "entry", SERVO_ENTRY_PIN, SERVO_ENTRY_LEDC_CHANNEL, false,                                      \
+		 SENSOR_ULTRASONIC_TRIG, SENSOR_ULTRASONIC_ECHO, RFID_SS_PIN},                                               \
+		{LANE_EXIT, "exit", SERVO_EXIT_PIN, SERVO_EXIT_LEDC_CHANNEL, SERVO_EXIT_INVERT,                              \
+		 LANE_NO_PIN, LANE_NO_PIN, RFID_EXIT_SS_PIN},                                                                \
+	}
+// Máximo de carriles por controlador (el simulador puede usar más que LANE_COUNT)
+#define LANE_MAX 4
+// Sesiones abiertas a la vez (autos adentro + los que están entrando)
+#define SESSION_MAX (SLOTS_COUNT + LANE_MAX)
+
+// ==================== AUTO-AJUSTE DE PARÁMETROS ====================
+
+// Modo adaptativo (AUTO_TUNE en /api/setParams) desactivado por defecto
+#define AUTOTUNE_DEFAULT false
+
+// Percentil objetivo de los tiempos observados y margen extra en %
+#define AUTOTUNE_PERCENTILE 95
+#define AUTOTUNE_MARGIN_PCT 25
+
+// Muestras mínimas antes de aplicar un valor aprendido y muestras
+// con las que se considera confianza completa
+#define AUTOTUNE_MIN_SAMPLES 20
+#define AUTOTUNE_FULL_CONFIDENCE_SAMPLES 100
+
+// Límites de seguridad de los valores aprendidos (ms)
+#define AUTOTUNE_TIMEOUT_MIN_MS 2000
+#define AUTOTUNE_TIMEOUT_MAX_MS 15000
+#define AUTOTUNE_EXIT_MIN_MS 1500
+#define AUTOTUNE_EXIT_MAX_MS 10000
+
+// ==================== WATCHDOG DEL LAZO ====================
+
+// Una etapa de loop() que dura más que esto cuenta como bloqueo (ms)
+#define WATCHDOG_STALL_MS 100
+
+// Sin avanzar de etapa durante este tiempo se reinicia la placa (ms)
+#define WATCHDOG_RESTART_MS 10000
+
+// Periodo del chequeo del watchdog (ms) y migas de pan guardadas en RTC
+#define WATCHDOG_POLL_MS 250
+#define WATCHDOG_BREADCRUMBS 16
+
+// ==================== DIAGNÓSTICO DE MEMORIA ====================
+
+// Periodo de muestreo del heap y de las pilas (ms)
+#define MEMDIAG_SAMPLE_MS 1000
+
+// Umbrales en bytes: heap libre o bloque más grande por debajo de LOW
+// deja de servir el dashboard; por debajo de CRITICAL también las rutas pesadas
+#define MEMDIAG_LOW_HEAP 40000
+#define MEMDIAG_CRITICAL_HEAP 20000
+#define MEMDIAG_LOW_BLOCK 8192
+#define MEMDIAG_CRITICAL_BLOCK 4096
+// Margen para volver a un nivel mejor (bytes)
+#define MEMDIAG_HYSTERESIS 4096
+
+// Tareas cuya pila se vigila (máximo MEMDIAG_MAX_TASKS)
+#define MEMDIAG_MAX_TASKS 8
+
+// Tamaño máximo aceptado de /config.json (bytes)
+#define CONFIG_FILE_MAX 1024
+
+// ==================== REGISTRO DE EVENTOS ====================
+
+// Eventos guardados para el collector (/api/events): con POLL_INTERVAL de 2 s
+// alcanza para ráfagas de varios eventos por segundo
+#define EVENT_LOG_CAPACITY 32
+
+// Eventos por respuesta de /api/events (el resto queda para la siguiente)
+#define EVENT_RESPONSE_MAX 12
 
 // ==================== MENSAJES DEL DISPLAY ====================
 
@@ -125,17 +263,34 @@
 #define MSG_TIMEOUT_1 "No se detectó"
 #define MSG_TIMEOUT_2 "Intentelo de nuevo"
 
+// Salida con lector: la tarjeta no tiene una entrada registrada
+#define MSG_NO_SESSION_1 "Sin entrada"
+#define MSG_NO_SESSION_2 "registrada"
+
+// Entrada: la tarjeta ya tiene un auto adentro
+#define MSG_INSIDE_1 "Tarjeta ya"
+#define MSG_INSIDE_2 "adentro"
+
+// Salida con tarjeta válida
+#define MSG_GOODBYE_1 "Hasta pronto!"
+#define MSG_GOODBYE_2 "Salida abierta"
+
 // ==================== TARJETAS RFID AUTORIZADAS ====================
 
 // Formato: "XX:XX:XX:XX"
+// La tabla se define una sola vez (parking_controller.cpp): config.h lo
+// incluyen casi todos los archivos
 
-static const char *AUTHORIZED_CARDS[] = {
-    "1C:21:09:49", // Tarjeta 1
-    "43:23:7A:1A"  // Tarjeta 2
-};
+#define AUTHORIZED_CARDS_LIST          \
+	{                                  \
+		"1C:21:09:49", /* Tarjeta 1 */ \
+		"43:23:7A:1A"  /* Tarjeta 2 */ \
+	}
 
 static const int AUTHORIZED_CARDS_COUNT = 2;
 
+extern const char *const AUTHORIZED_CARDS[AUTHORIZED_CARDS_COUNT];
+
 // ==================== CONFIGURACIÓN AVANZADA ====================
 
 // Baudrate del Serial Monitor
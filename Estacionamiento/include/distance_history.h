@@ -0,0 +1,119 @@
+// =====================================================================
+// HISTORIAL DE DISTANCIA DEL ULTRASÓNICO (multi-resolución, memoria fija)
+// =====================================================================
+//
+// Guarda las lecturas del sensor ultrasónico en tres anillos:
+//   - RAW: muestras crudas (último minuto aprox.)
+//   - 1S : buckets de 1 segundo con min/max/promedio
+//   - 1M : buckets de 1 minuto con min/max/promedio
+// Todas las distancias son enteras en milímetros (sin float).
+// Los carriles comparten los anillos: cada registro lleva su carril y las
+// consultas filtran por él. Cada add() es O(1): acumula en el bucket abierto
+// del carril y, al cambiar de segundo/minuto, empuja los buckets abiertos
+// (todos del mismo segundo/minuto) a su anillo, así el anillo queda ordenado.
+
+#ifndef DISTANCE_HISTORY_H
+#define DISTANCE_HISTORY_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include "config.h"
+
+// Las máscaras de buckets abiertos tienen un bit por carril
+#if LANE_MAX > 8
+#error "DistanceHistory admite hasta 8 carriles (LANE_MAX)"
+#endif
+
+// Resoluciones disponibles para consulta
+enum HistoryResolution
+{
+	HISTORY_RAW = 0,
+	HISTORY_1S = 1,
+	HISTORY_1M = 2
+};
+
+struct DistanceSample
+{
+	uint32_t tMs; // millis() de la lectura
+	uint16_t mm;  // distancia en mm
+	uint8_t lane; // carril del sensor
+};
+
+struct DistanceBucket
+{
+	uint32_t tMs;  // inicio del bucket (millis alineado a la resolución)
+	uint16_t minMm;
+	uint16_t maxMm;
+	uint32_t sumMm; // suma para calcular el promedio
+	uint16_t count;
+	uint8_t lane;
+
+	uint16_t meanMm() const { return count ? (uint16_t)(sumMm / count) : 0; }
+};
+
+// Anillo de capacidad fija: al llenarse sobrescribe el elemento más antiguo
+template <typename T, size_t N>
+class HistoryRing
+{
+public:
+	void push(const T &item)
+	{
+		items[head] = item;
+		head = (head + 1) % N;
+		if (used < N)
+			used++;
+	}
+	size_t size() const { return used; }
+	// i = 0 es el elemento más antiguo
+	const T &at(size_t i) const { return items[(head + N - used + i) % N]; }
+
+private:
+	T items[N];
+	size_t head = 0;
+	size_t used = 0;
+};
+
+class DistanceHistory
+{
+public:
+	// Registrar una lectura válida del carril lane (< LANE_MAX)
+	void add(uint32_t nowMs, uint16_t mm, uint8_t lane);
+
+	// Número de elementos disponibles en la resolución, de todos los carriles
+	// (incluye los buckets abiertos)
+	size_t count(HistoryResolution res) const;
+	// Acceso por índice, 0 = más antiguo
+	DistanceSample rawAt(size_t i) const { return raw.at(i); }
+	DistanceBucket bucketAt(HistoryResolution res, size_t i) const;
+
+	// Índice del primer elemento con tMs >= sinceMs (búsqueda binaria)
+	size_t firstIndexSince(HistoryResolution res, uint32_t sinceMs) const;
+
+	// Convierte texto de query ("raw", "1s", "1m") a resolución
+	static bool parseResolution(const char *text, HistoryResolution &res);
+
+private:
+	uint32_t timeAt(HistoryResolution res, size_t i) const;
+	static void openBucket(DistanceBucket &b, uint32_t tMs, uint16_t mm);
+	static void accumulate(DistanceBucket &b, uint16_t mm);
+	// Acumula mm en el bucket abierto de lane; si el período cambió, primero
+	// cierra los abiertos de todos los carriles
+	template <size_t N>
+	static void addTo(HistoryRing<DistanceBucket, N> &ring, DistanceBucket *open, uint8_t &openMask,
+					  uint32_t start, uint16_t mm, uint8_t lane);
+	static DistanceBucket openAt(const DistanceBucket *open, uint8_t openMask, size_t k);
+	static size_t openCount(uint8_t openMask);
+
+	HistoryRing<DistanceSample, HISTORY_RAW_CAPACITY> raw;
+	HistoryRing<DistanceBucket, HISTORY_1S_CAPACITY> seconds;
+	HistoryRing<DistanceBucket, HISTORY_1M_CAPACITY> minutes;
+
+	// Buckets abiertos por carril; bit i de la máscara = el carril i tiene uno
+	DistanceBucket openSecond[LANE_MAX] = {};
+	DistanceBucket openMinute[LANE_MAX] = {};
+	uint8_t openSeconds = 0;
+	uint8_t openMinutes = 0;
+};
+
+#endif // DISTANCE_HISTORY_H
@@ -0,0 +1,64 @@
+// =====================================================================
+// REGISTRO DE EVENTOS (número de secuencia + millis)
+// =====================================================================
+//
+// Cada cambio que ve el controlador (cajón ocupado/libre, tarjeta leída,
+// pluma arriba/abajo) se guarda con un número de secuencia creciente y el
+// millis() en que se detectó. El collector los pide con
+// /api/events?since=<seq> y lleva esos sellos hasta la BD, así la GUI
+// puede medir cuánto tarda cada etapa (firmware -> API -> BD -> GUI).
+//
+// Anillo de EVENT_LOG_CAPACITY eventos: si el collector tarda demasiado
+// los más viejos se pierden, y oldestSeq() lo deja ver. La secuencia
+// empieza en 1 en cada arranque (0 = ningún evento); el id de arranque
+// (aleatorio) le avisa al collector que la numeración volvió a empezar.
+
+#ifndef EVENT_LOG_H
+#define EVENT_LOG_H
+
+#include <stdint.h>
+
+#include "config.h"
+
+enum EventType : uint8_t
+{
+	EVT_SLOT, // index = cajón, value = 1 ocupado / 0 libre
+	EVT_CARD, // index = carril, value = 1 autorizada / 0 rechazada
+	EVT_GATE, // index = carril, value = 1 levantada / 0 cerrada
+	EVT_TYPE_COUNT
+};
+
+struct LoggedEvent
+{
+	uint32_t seq;
+	uint32_t tMs; // millis() de la detección
+	uint8_t type;
+	uint8_t index;
+	uint8_t value;
+};
+
+class EventLog
+{
+public:
+	// Guardar un evento; devuelve su número de secuencia
+	uint32_t record(uint8_t type, uint8_t index, uint8_t value, uint32_t nowMs);
+
+	// Último número asignado (0 = ninguno) y el más viejo que sigue en el anillo
+	uint32_t lastSeq() const { return nextSeq - 1; }
+	uint32_t oldestSeq() const;
+	// Evento con ese número, o nullptr si ya se pisó o no existe
+	const LoggedEvent *find(uint32_t seq) const;
+
+	// Identificador de este arranque (lo fija el firmware al iniciar)
+	void setBootId(uint32_t id) { boot = id; }
+	uint32_t bootId() const { return boot; }
+
+	static const char *typeName(uint8_t type);
+
+private:
+	LoggedEvent ring[EVENT_LOG_CAPACITY] = {};
+	uint32_t nextSeq = 1;
+	uint32_t boot = 0;
+};
+
+#endif // EVENT_LOG_H
@@ -0,0 +1,164 @@
+// =====================================================================
+// CARRIL (PLUMA) INDEPENDIENTE
+// =====================================================================
+//
+// Cada carril tiene su servo, su detector, su máquina de estados y sus
+// temporizadores, así varios carriles avanzan en el mismo loop() sin
+// que los tiempos de uno afecten a otro. El carril no decide quién pasa
+// ni cuenta cajones: devuelve eventos (GATE_EVT_*) y ParkingController
+// reacciona (mensajes, reservas, auto-ajuste).
+//
+// Entrada: 0 = INACTIVO, 1 = ESPERANDO CARRO, 3 = ESPERA ANTES DE BAJAR,
+//          4 = BAJANDO (hasta el evento "cerrada")
+// Salida:  0 = INACTIVO, 1 = SUBIENDO, 2 = ABIERTA (esperando para bajar),
+//          3 = BAJANDO
+
+#ifndef GATE_H
+#define GATE_H
+
+#include <stdint.h>
+
+#include "config.h"
+#include "hal.h"
+#include "soft_timer.h"
+#include "ultrasonic_filter.h"
+
+enum LaneKind : uint8_t
+{
+	LANE_ENTRY,
+	LANE_EXIT
+};
+
+// Una fila de LANE_TABLE (config.h)
+struct LaneConfig
+{
+	uint8_t kind;
+	const char *name;
+	uint8_t servoPin;
+	uint8_t ledcChannel;
+	bool invertServo;
+	uint8_t trigPin;
+	uint8_t echoPin;
+	uint8_t rfidSsPin;
+};
+
+// Eventos devueltos por update()/checkDetector() (se combinan con OR)
+#define GATE_EVT_DETECTED 0x01 // primera detección del auto en esta pasada
+#define GATE_EVT_PASSED 0x02   // el auto dejó de bloquear el sensor
+#define GATE_EVT_TIMEOUT 0x04  // no pasó ningún auto: la pluma va a bajar
+#define GATE_EVT_LOWERING 0x08 // la pluma empezó a bajar
+#define GATE_EVT_CLOSED 0x10   // la pluma llegó abajo
+#define GATE_EVT_SAMPLE 0x20   // lectura válida del ultrasónico
+
+// Tiempos acumulados de un carril (ms)
+struct GateLatency
+{
+	uint32_t count = 0;
+	uint64_t totalMs = 0;
+	uint32_t maxMs = 0;
+
+	void add(uint32_t ms)
+	{
+		count++;
+		totalMs += ms;
+		if (ms > maxMs)
+			maxMs = ms;
+	}
+	uint32_t meanMs() const { return count ? (uint32_t)(totalMs / count) : 0; }
+};
+
+class Gate
+{
+public:
+	void attach(const LaneConfig &config, HalServo &servo, HalPulseCapture *detector, HalRfidReader *reader);
+	// Posicionar la pluma abajo
+	void begin(uint32_t nowMs);
+
+	// Timeout sin auto (entrada) y espera con la pluma arriba (salida)
+	void setTiming(uint32_t noCarTimeoutMs, uint32_t holdMs);
+	// Entrada: abrir para un auto autorizado
+	void admit(uint32_t nowMs);
+	// Salida: abrir, o extender la espera si ya está abierta
+	void open(uint32_t nowMs);
+	// Eventos del servo y temporizadores de la máquina de estados
+	uint8_t update(uint32_t nowMs);
+	// Lectura del ultrasónico mientras la pluma de entrada está levantada
+	uint8_t checkDetector(uint32_t nowMs);
+
+	const LaneConfig &config() const { return *cfg; }
+	const char *name() const { return cfg->name; }
+	bool isEntry() const { return cfg->kind == LANE_ENTRY; }
+	HalRfidReader *reader() const { return rfid; }
+	bool hasDetector() const { return detector != nullptr; }
+
+	int phase() const { return gatePhase; }
+	bool isRaised() const { return raised; }
+	// Abajo y sin nada en curso: update()/checkDetector() no hacen nada hasta una orden
+	bool isIdle() const { return gatePhase == 0 && !raised; }
+	// La pasada actual tuvo al menos una detección del auto
+	bool carSeen() const { return carDetectedRecently; }
+	// Tiempos de la última detección / pasada (para el auto-ajuste)
+	uint32_t approachMs() const { return lastApproachMs; }
+	uint32_t passageMs() const { return lastPassageMs; }
+	bool passageMeasured() const { return lastPassageValid; }
+	const UltrasonicFilter &filter() const { return ultrasonicFilter; }
+
+	// Throughput y latencias del carril
+	uint32_t passes() const { return passCount; }
+	uint32_t timeouts() const { return timeoutCount; }
+	uint32_t passesPerHour() const;
+	const GateLatency &cycle() const { return cycleStats; }
+	const GateLatency &openLatency() const { return openStats; }
+
+private:
+	void raise(uint32_t nowMs);
+	void lower();
+	uint8_t handleServoEvent(uint32_t nowMs);
+	int servoAngle(int angle) const { return cfg->invertServo ? 180 - angle : angle; }
+
+	const LaneConfig *cfg = nullptr;
+	HalServo *servo = nullptr;
+	HalPulseCapture *detector = nullptr;
+	HalRfidReader *rfid = nullptr;
+
+	int gatePhase = 0;
+	// Levantada desde que empieza a subir hasta el evento "cerrada"
+	bool raised = false;
+	// Destino comandado y si ya llegó arriba (evento "abierta")
+	int target = SERVO_ANGLE_DOWN;
+	bool fullyOpen = false;
+
+	SoftTimer ultrasonicTimer{ULTRASONIC_CHECK_INTERVAL};
+	// Timeout: si no detecta auto, baja la pluma
+	SoftTimer noCarTimer{ULTRASONIC_TIMEOUT_MS};
+	// Esperar antes de bajar
+	SoftTimer lowerWaitTimer{LOWER_BARRIER_WAIT_MS};
+	// Salida: tiempo con la pluma arriba y cuándo empezó la espera
+	uint32_t holdMs = EXIT_HOLD_MS;
+	uint32_t holdStartMs = 0;
+
+	// Flag: el auto fue detectado alguna vez
+	bool carDetectedRecently = false;
+	// Flag: el auto está siendo detectado ahora
+	bool carCurrentlyDetected = false;
+	// La pasada actual tiene una detección medida (se espera su tiempo de paso)
+	bool passageTiming = false;
+	uint32_t openMillis = 0;
+	uint32_t carDetectedMillis = 0;
+	uint32_t lastApproachMs = 0;
+	uint32_t lastPassageMs = 0;
+	bool lastPassageValid = false;
+	UltrasonicFilter ultrasonicFilter;
+
+	uint32_t startedMs = 0;
+	uint32_t lastUpdateMs = 0;
+	uint32_t passCount = 0;
+	uint32_t timeoutCount = 0;
+	// Orden de subir -> "cerrada" (ciclo completo) y orden de subir -> "abierta"
+	uint32_t cycleStartMs = 0;
+	uint32_t raiseCmdMs = 0;
+	GateLatency cycleStats;
+	GateLatency openStats;
+};
+
+#endif // GATE_H
@@ -0,0 +1,95 @@
+// =====================================================================
+// CAPA DE ABSTRACCIÓN DE HARDWARE (HAL)
+// =====================================================================
+//
+// La lógica de plumas y cajones (ParkingController) solo habla con estas
+// interfaces. En el ESP32 se implementan sobre Arduino/MFRC522/LEDC/SSD1306
+// (hal_arduino.h) y en [env:native] sobre un simulador con reloj virtual
+// (src/native/).
+
+#ifndef HAL_H
+#define HAL_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+// Niveles y modos (mismos valores que Arduino)
+#define HAL_LOW 0
+#define HAL_HIGH 1
+#define HAL_INPUT 0x01
+#define HAL_OUTPUT 0x03
+#define HAL_INPUT_PULLUP 0x05
+
+class HalClock
+{
+public:
+	virtual ~HalClock() {}
+	// Milisegundos monotónicos desde el arranque
+	virtual uint32_t millis() = 0;
+	// Microsegundos monotónicos (medición de operaciones cortas, da la vuelta)
+	virtual uint32_t micros() = 0;
+	// Fecha/hora "YYYY-MM-DD HH:MM:SS"; false si no hay hora válida
+	virtual bool formatWallTime(char *buf, size_t len) = 0;
+};
+
+class HalGpio
+{
+public:
+	virtual ~HalGpio() {}
+	virtual void pinMode(uint8_t pin, uint8_t mode) = 0;
+	virtual void digitalWrite(uint8_t pin, uint8_t level) = 0;
+	virtual int digitalRead(uint8_t pin) = 0;
+};
+
+// Captura de pulso del ultrasónico: genera TRIG y mide ECHO
+class HalPulseCapture
+{
+public:
+	virtual ~HalPulseCapture() {}
+	// Duración del eco en us; 0 si hubo timeout
+	virtual uint32_t measureEchoUs() = 0;
+};
+
+// Resultado de un paso de lectura RFID
+enum RfidPoll : uint8_t
+{
+	RFID_NONE,    // sin tarjeta (o transacción terminada)
+	RFID_PENDING, // transacción en curso: volver a llamar pronto
+	RFID_CARD     // UID completo en uid; falta cerrar la transacción
+};
+
+// Lector RFID no bloqueante: cada poll() hace un solo paso de la transacción
+// (REQA, anticolisión/SELECT, HALT), así varios lectores en el mismo bus se
+// pueden intercalar (RfidScheduler)
+class HalRfidReader
+{
+public:
+	virtual ~HalRfidReader() {}
+	virtual uint8_t poll(char *uid, size_t len) = 0;
+};
+
+// Servo con trayectoria en segundo plano (ServoMotion)
+class HalServo
+{
+public:
+	virtual ~HalServo() {}
+	// Posicionar de inmediato, sin trayectoria (arranque)
+	virtual void setAngle(int angle) = 0;
+	// Iniciar trayectoria hacia angle; no bloquea
+	virtual void moveTo(int angle) = 0;
+	// true una sola vez cuando la trayectoria llegó al destino
+	virtual bool takeArrived() = 0;
+};
+
+class HalDisplay
+{
+public:
+	virtual ~HalDisplay() {}
+	virtual void showMessage(const char *line1, const char *line2) = 0;
+	virtual void clear() = 0;
+};
+
+// Log de depuración (Serial en el ESP32, stderr en el simulador)
+void halLogf(const char *fmt, ...);
+
+#endif // HAL_H
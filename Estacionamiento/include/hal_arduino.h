@@ -0,0 +1,93 @@
+// =====================================================================
+// HAL SOBRE ARDUINO (solo firmware ESP32)
+// =====================================================================
+
+#ifndef HAL_ARDUINO_H
+#define HAL_ARDUINO_H
+
+#include <Arduino.h>
+#include <Adafruit_SSD1306.h>
+#include <MFRC522.h>
+#include <esp_timer.h>
+
+#include "hal.h"
+#include "servo_motion.h"
+
+class ArduinoClock : public HalClock
+{
+public:
+	uint32_t millis() override;
+	uint32_t micros() override;
+	bool formatWallTime(char *buf, size_t len) override;
+};
+
+class ArduinoGpio : public HalGpio
+{
+public:
+	void pinMode(uint8_t pin, uint8_t mode) override;
+	void digitalWrite(uint8_t pin, uint8_t level) override;
+	int digitalRead(uint8_t pin) override;
+};
+
+// Los dispositivos por carril se crean en arreglos y reciben sus pines de
+// LANE_TABLE en begin()
+class ArduinoUltrasonic : public HalPulseCapture
+{
+public:
+	void begin(uint8_t trigPin, uint8_t echoPin);
+	uint32_t measureEchoUs() override;
+
+private:
+	uint8_t trig = 0;
+	uint8_t echo = 0;
+};
+
+// Lector MFRC522 en el bus SPI compartido (SPI.begin() una vez antes).
+// La transacción se reparte en pasos: REQA, anticolisión/SELECT y HALT
+class ArduinoRfidReader : public HalRfidReader
+{
+public:
+	void begin(uint8_t ssPin, uint8_t rstPin);
+	uint8_t poll(char *uid, size_t len) override;
+
+private:
+	MFRC522 rfid;
+	uint8_t step = 0;
+};
+
+// Servo por PWM de hardware (LEDC). Un esp_timer cada SERVO_TICK_MS avanza
+// la trayectoria y actualiza el duty, sin depender de loop().
+class ArduinoServo : public HalServo
+{
+public:
+	void begin(uint8_t servoPin, uint8_t ledcChannel);
+	void setAngle(int angle) override;
+	void moveTo(int angle) override;
+	bool takeArrived() override;
+
+private:
+	static void onTick(void *arg);
+	void tick();
+	void writePulse(int32_t centiDeg);
+
+	uint8_t pin = 0;
+	uint8_t channel = 0;
+	ServoMotion motion;
+	int32_t lastWritten = -1;
+	// Protege motion entre loop() y la tarea de esp_timer
+	portMUX_TYPE lock = portMUX_INITIALIZER_UNLOCKED;
+	esp_timer_handle_t timer = nullptr;
+};
+
+class ArduinoDisplay : public HalDisplay
+{
+public:
+	explicit ArduinoDisplay(Adafruit_SSD1306 &oled) : display(oled) {}
+	void showMessage(const char *line1, const char *line2) override;
+	void clear() override;
+
+private:
+	Adafruit_SSD1306 &display;
+};
+
+#endif // HAL_ARDUINO_H
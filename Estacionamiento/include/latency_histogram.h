@@ -0,0 +1,38 @@
+// =====================================================================
+// HISTOGRAMA DE LATENCIAS (memoria fija)
+// =====================================================================
+//
+// Buckets log-lineales: 4 sub-buckets por cada potencia de 2 de
+// microsegundos, desde 16 us hasta ~16 s. El error de un percentil es
+// como máximo ~19% del valor, suficiente para p50/p99 del lazo de control.
+
+#ifndef LATENCY_HISTOGRAM_H
+#define LATENCY_HISTOGRAM_H
+
+#include <stdint.h>
+
+#define LATENCY_OCTAVES 20
+#define LATENCY_SUBBUCKETS 4
+#define LATENCY_BUCKETS (LATENCY_OCTAVES * LATENCY_SUBBUCKETS + 1)
+
+class LatencyHistogram
+{
+public:
+	void record(uint32_t us);
+	void reset();
+
+	uint32_t count() const { return total; }
+	uint32_t maxUs() const { return maxValue; }
+	// Cota superior del bucket que contiene el percentil p (0-100)
+	uint32_t percentileUs(uint8_t p) const;
+
+private:
+	static uint8_t bucketFor(uint32_t us);
+	static uint32_t bucketUpperUs(uint8_t bucket);
+
+	uint32_t buckets[LATENCY_BUCKETS] = {};
+	uint32_t total = 0;
+	uint32_t maxValue = 0;
+};
+
+#endif // LATENCY_HISTOGRAM_H
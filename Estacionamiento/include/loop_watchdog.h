@@ -0,0 +1,120 @@
+// =====================================================================
+// WATCHDOG DEL LAZO DE CONTROL (etapas, bloqueos y migas de pan)
+// =====================================================================
+//
+// loop() marca la etapa en la que entra (HTTP, plumas, RFID,
+// ultrasónico...). Cada cambio de etapa cierra la anterior y, si duró
+// más de WATCHDOG_STALL_MS, la cuenta como bloqueo (cantidad y el más
+// largo por etapa).
+// Las migas de pan son los últimos WATCHDOG_BREADCRUMBS sucesos reales
+// (bloqueos, tarjetas, plumas, cajones, escrituras en flash) con la etapa
+// en la que ocurrieron; los cambios de etapa no dejan miga, así el anillo
+// cubre lo que pasó antes de colgarse y no solo las últimas vueltas.
+// Todo vive en un WatchdogRecord que el firmware ubica en memoria RTC
+// (sobrevive a un reinicio por software), así en el siguiente arranque
+// se puede ver qué estaba haciendo la placa cuando se colgó.
+//
+// poll() se llama desde otra tarea (esp_timer en el ESP32): si la
+// secuencia de etapas no avanzó en WATCHDOG_RESTART_MS, el lazo está
+// colgado y el llamador reinicia la placa. Solo se comparte un contador
+// de 32 bits, así que no hace falta sección crítica.
+
+#ifndef LOOP_WATCHDOG_H
+#define LOOP_WATCHDOG_H
+
+#include <stdint.h>
+
+#include "config.h"
+
+enum LoopStage : uint8_t
+{
+	STAGE_IDLE,
+	STAGE_HTTP,
+	STAGE_BARRIERS,
+	STAGE_DISPLAY,
+	STAGE_RFID,
+	STAGE_ULTRASONIC,
+	STAGE_SLOTS,
+	STAGE_FS,
+	STAGE_COUNT
+};
+
+// Tipo de miga de pan; index/value según el tipo
+enum CrumbKind : uint8_t
+{
+	CRUMB_STALL, // index = etapa bloqueada, value = ms
+	CRUMB_CARD,  // index = carril, value = 1 autorizada / 0 rechazada
+	CRUMB_GATE,  // index = carril, value = 1 levantada / 0 cerrada
+	CRUMB_SLOT,  // index = cajón, value = 1 ocupado / 0 libre
+	CRUMB_FS,    // value = ms que tardó la escritura
+	CRUMB_COUNT
+};
+
+struct Breadcrumb
+{
+	uint32_t tMs;
+	uint32_t value;
+	uint8_t kind;
+	uint8_t stage; // etapa del lazo en ese momento
+	uint8_t index;
+};
+
+// Estado persistente entre reinicios (memoria RTC en el ESP32)
+struct WatchdogRecord
+{
+	uint32_t magic;
+	uint32_t bootCount;
+	uint32_t restarts;         // reinicios provocados por el watchdog
+	volatile uint32_t seq;     // avanza en cada cambio de etapa
+	uint8_t stage;             // etapa actual
+	uint32_t stageStartMs;     // inicio de la etapa actual
+	uint8_t restartRequested;  // este arranque terminó en un reinicio del watchdog
+	uint32_t restartStalledMs; // cuánto llevaba colgada la etapa al reiniciar
+	uint8_t crumbHead;
+	uint8_t crumbCount;
+	Breadcrumb crumbs[WATCHDOG_BREADCRUMBS];
+	uint32_t stalls[STAGE_COUNT];
+	uint32_t longestStallMs[STAGE_COUNT];
+};
+
+class LoopWatchdog
+{
+public:
+	// Tomar el registro persistente: si es válido se conserva como
+	// "arranque anterior" y se reinicia para el arranque actual
+	void begin(WatchdogRecord &record, uint32_t nowMs);
+
+	// Entrar a una etapa; devuelve la anterior (para volver a ella)
+	uint8_t enter(uint8_t stage, uint32_t nowMs);
+	// El lazo se saltó a propósito hasta nowMs (el simulador adelanta el
+	// reloj en reposo): la etapa actual sigue desde ahí, sin contar bloqueo
+	void resume(uint32_t nowMs) { record->stageStartMs = nowMs; }
+	// Dejar una miga de pan (CrumbKind)
+	void note(uint8_t kind, uint8_t index, uint32_t value, uint32_t nowMs);
+
+	// Desde otra tarea: true si el lazo no avanzó en WATCHDOG_RESTART_MS
+	bool poll(uint32_t nowMs);
+	// Anotar el reinicio en el registro persistente (antes de reiniciar)
+	void markRestart(uint32_t nowMs);
+
+	const WatchdogRecord &current() const { return *record; }
+	// Registro del arranque anterior (válido si hasPrevious())
+	const WatchdogRecord &previous() const { return last; }
+	bool hasPrevious() const { return lastValid; }
+
+	static const char *stageName(uint8_t stage);
+	static const char *crumbName(uint8_t kind);
+	// Migas de pan de la más vieja (0) a la más nueva
+	static const Breadcrumb &crumbAt(const WatchdogRecord &rec, uint8_t index);
+
+private:
+	WatchdogRecord *record = nullptr;
+	WatchdogRecord last = {};
+	bool lastValid = false;
+
+	// Estado propio de poll()
+	uint32_t seenSeq = 0;
+	uint32_t seenAtMs = 0;
+};
+
+#endif // LOOP_WATCHDOG_H
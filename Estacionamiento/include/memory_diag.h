@@ -0,0 +1,82 @@
+// =====================================================================
+// DIAGNÓSTICO DE MEMORIA (heap, pilas y documentos JSON)
+// =====================================================================
+//
+// Guarda la última muestra del heap (libre, mínimo histórico y bloque
+// más grande asignable), el margen de pila que le queda a cada tarea y
+// decide el nivel de memoria:
+// - MEM_NORMAL: se atiende todo;
+// - MEM_LOW: se deja de servir el dashboard (archivos de LittleFS);
+// - MEM_CRITICAL: además se cortan las rutas pesadas (/api/history,
+//   /api/loopStats), para que el lazo de control no se quede sin heap.
+// Para volver a un nivel mejor hay que superar el umbral por
+// MEMDIAG_HYSTERESIS bytes. Quién toma las muestras depende de la
+// plataforma (ESP.getFreeHeap() en el ESP32, el simulador las inventa).
+
+#ifndef MEMORY_DIAG_H
+#define MEMORY_DIAG_H
+
+#include <stdint.h>
+
+#include "config.h"
+
+enum MemoryLevel : uint8_t
+{
+	MEM_NORMAL,
+	MEM_LOW,
+	MEM_CRITICAL
+};
+
+// Clases de rutas HTTP según lo prescindibles que son
+enum RouteClass : uint8_t
+{
+	ROUTE_ESSENTIAL, // estado, parámetros, diagnóstico
+	ROUTE_HEAVY,     // historial y estadísticas del lazo
+	ROUTE_DASHBOARD  // index.html, style.css, script.js
+};
+
+struct MemorySample
+{
+	uint32_t freeHeap;
+	uint32_t minFreeHeap;
+	uint32_t largestBlock;
+};
+
+struct TaskStack
+{
+	const char *name;
+	uint32_t freeBytes; // marca de agua: lo mínimo que le quedó libre
+};
+
+class MemoryDiag
+{
+public:
+	// Registrar una muestra del heap y recalcular el nivel
+	void record(const MemorySample &sample);
+	// Marca de agua de la pila de una tarea (se agrega la primera vez)
+	void recordStack(const char *task, uint32_t freeBytes);
+
+	const MemorySample &last() const { return sample; }
+	// % del heap libre que no está en el bloque más grande
+	uint8_t fragmentationPct() const;
+	MemoryLevel level() const { return current; }
+	static const char *levelName(MemoryLevel level);
+
+	// false si el nivel actual corta esta clase de ruta (y la cuenta)
+	bool allows(RouteClass route);
+	uint32_t shedCount() const { return shed; }
+
+	uint8_t taskCount() const { return tasks; }
+	const TaskStack &task(uint8_t i) const { return stacks[i]; }
+
+private:
+	MemoryLevel levelFor(uint32_t freeHeap, uint32_t block, uint32_t margin) const;
+
+	MemorySample sample = {};
+	MemoryLevel current = MEM_NORMAL;
+	uint32_t shed = 0;
+	TaskStack stacks[MEMDIAG_MAX_TASKS] = {};
+	uint8_t tasks = 0;
+};
+
+#endif // MEMORY_DIAG_H
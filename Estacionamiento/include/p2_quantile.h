@@ -0,0 +1,38 @@
+// =====================================================================
+// CUANTIL EN STREAMING (algoritmo P², Jain & Chlamtac 1985)
+// =====================================================================
+//
+// Estima un cuantil con 5 marcadores, sin guardar las muestras: memoria
+// fija y O(1) por muestra. Mientras haya menos de 5 muestras se usa el
+// cuantil exacto de las que hay.
+
+#ifndef P2_QUANTILE_H
+#define P2_QUANTILE_H
+
+#include <stdint.h>
+
+class P2Quantile
+{
+public:
+	// p entre 0 y 1 (0.95 = percentil 95)
+	explicit P2Quantile(float p);
+
+	void add(float x);
+	void reset();
+
+	uint32_t count() const { return total; }
+	float value() const;
+
+private:
+	float p;
+	float heights[5];
+	int32_t positions[5];
+	float desired[5];
+	float increments[5];
+	uint32_t total = 0;
+
+	float parabolic(int i, int d) const;
+	float linear(int i, int d) const;
+};
+
+#endif // P2_QUANTILE_H
@@ -0,0 +1,172 @@
+// =====================================================================
+// LÓGICA DE PLUMAS Y CAJONES (independiente del hardware)
+// =====================================================================
+//
+// Reparte las tarjetas RFID y los cajones liberados entre los carriles
+// (Gate, uno por fila de LANE_TABLE), lleva el conteo compartido de cajones
+// y la pantalla. Todo el acceso a hardware pasa por la HAL, así el mismo
+// código corre en el ESP32 y en el simulador nativo.
+
+#ifndef PARKING_CONTROLLER_H
+#define PARKING_CONTROLLER_H
+
+#include <stdint.h>
+
+#include "config.h"
+#include "hal.h"
+#include "soft_timer.h"
+#include "distance_history.h"
+#include "gate.h"
+#include "slot_inventory.h"
+#include "rfid_scheduler.h"
+#include "session_table.h"
+#include "event_log.h"
+#include "auto_tuner.h"
+#include "loop_watchdog.h"
+
+// Tamaño de los textos de UID y fecha/hora expuestos por la API
+#define UID_TEXT_LEN 24
+#define TIME_TEXT_LEN 24
+
+struct ParkingHal
+{
+	HalClock &clock;
+	HalGpio &gpio;
+	HalDisplay &display;
+};
+
+class ParkingController
+{
+public:
+	explicit ParkingController(const ParkingHal &hal);
+
+	// Agregar un carril (antes de begin()); false si ya hay LANE_MAX
+	bool addLane(const LaneConfig &config, HalServo &servo, HalPulseCapture *detector, HalRfidReader *reader);
+	// Configurar pines, posicionar plumas y mostrar pantalla inicial
+	void begin();
+	// Un ciclo de loop(): plumas, pantalla, RFID, ultrasónico y cajones
+	void update();
+	// Marcar cada etapa de update() en el watchdog del lazo (opcional)
+	void setWatchdog(LoopWatchdog *wd) { watchdog = wd; }
+
+	// Parámetros configurables (/api/setParams, config.json): los valores
+	// manuales, que se guardan aunque el auto-ajuste los reemplace
+	int salidaDelayMs = EXIT_HOLD_MS;
+	int ultrasonicTimeoutMs = ULTRASONIC_TIMEOUT_MS;
+	// Modo adaptativo: se usan los valores aprendidos que ya tengan muestras suficientes
+	bool autoTune = AUTOTUNE_DEFAULT;
+	// Valores en uso: el aprendido (con autoTune y listo) o el manual
+	int effectiveSalidaDelayMs() const;
+	int effectiveUltrasonicTimeoutMs() const;
+	// Aplicar los valores en uso a los temporizadores de los carriles
+	void applyParams();
+	// Hasta cuándo update() no tiene nada que hacer sin entradas nuevas
+	// (nowMs si hay algo en curso). El simulador salta el reloj hasta ahí
+	uint32_t idleUntilMs(uint32_t nowMs) const;
+
+	// Estado expuesto por la API (plumaEntrada/plumaSalida = primer carril de cada tipo)
+	const char *latestRFIDUID() const { return lastUid; }
+	float lastDistanceCm() const { return entryLane >= 0 ? laneDistance[entryLane] : 0.0f; }
+	float lastDistanceCm(int lane) const { return laneDistance[lane]; }
+	bool isEntranceBarrierRaised() const { return entryLane >= 0 && lanes[entryLane].isRaised(); }
+	bool isExitBarrierRaised() const { return exitLane >= 0 && lanes[exitLane].isRaised(); }
+	bool isSlotOccupied(int slot) const { return slotOccupied[slot]; }
+	const char *lastEntryTime(int slot) const { return entryTime[slot]; }
+	const char *lastExitTime(int slot) const { return exitTime[slot]; }
+	int getAvailableSlots() const { return inventory.available(); }
+	int getReservedSlots() const { return inventory.reservations(); }
+	int getEntrancePhase() const { return entryLane >= 0 ? lanes[entryLane].phase() : 0; }
+	int getExitPhase() const { return exitLane >= 0 ? lanes[exitLane].phase() : 0; }
+	int laneCount() const { return lanesUsed; }
+	int entryLaneIndex() const { return entryLane; }
+	const Gate &lane(int i) const { return lanes[i]; }
+	const RfidScheduler &readers() const { return rfidScheduler; }
+	// La salida abre solo con la tarjeta de una sesión abierta (hay lector de salida)
+	bool exitRequiresCard() const { return exitByCard; }
+	int openSessions() const { return sessions.count(); }
+	const DistanceHistory &history() const { return distanceHistory; }
+	const AutoTuner &learned() const { return tuner; }
+	// Cambios de cajones, tarjetas y plumas con secuencia y millis (/api/events)
+	const EventLog &events() const { return eventLog; }
+	void setBootId(uint32_t id) { eventLog.setBootId(id); }
+
+private:
+	void checkRFID();
+	bool isCardAuthorized(const char *cardUID);
+	void handleAuthorizedUser(int lane, const char *cardUID);
+	void handleExitCard(int lane, const char *cardUID);
+	void handleUnauthorizedUser();
+	void showTimedMessage(const char *line1, const char *line2);
+	void checkUltrasonicSensor();
+	void handleLaneEvents(int lane, uint8_t events);
+	void startExitSequence();
+	void checkParkingSlots();
+	void updateLED(int slot, bool occupied);
+	void displayMessage(const char *line1, const char *line2 = "");
+	void updateBarrierLogic();
+	void updateDisplayLogic();
+	void displayAvailableSlots();
+	void formatTime(char *buf);
+	void enterStage(uint8_t stage);
+	void recordGateChanges();
+	void logEvent(uint8_t type, uint8_t index, uint8_t value);
+	void holdParkReservation(int session, uint32_t nowMs);
+	void takeParkReservation(uint32_t nowMs);
+	void releaseParkReservation(int session);
+	void expireParkReservations(uint32_t nowMs);
+
+	ParkingHal hal;
+	LoopWatchdog *watchdog = nullptr;
+
+	bool slotOccupied[SLOTS_COUNT] = {};
+	bool deniedMessageActive = false;
+	bool authorizedMessageActive = false;
+	bool timeoutMessageActive = false;
+
+	SoftTimer displayMessageTimer{DISPLAY_MESSAGE_MS};
+	SoftTimer successMessageTimer{SUCCESS_MESSAGE_MS};
+
+	// Carriles y, para la API, el primero de entrada y de salida (-1 = ninguno)
+	Gate lanes[LANE_MAX];
+	int lanesUsed = 0;
+	int entryLane = -1;
+	int exitLane = -1;
+	// El carril tiene una reserva que todavía no usó ningún auto, y su sesión
+	bool laneReserved[LANE_MAX] = {};
+	int laneSession[LANE_MAX];
+
+	// Lectores de todos los carriles, atendidos en round-robin
+	RfidScheduler rfidScheduler;
+	// Sesiones entrada -> salida (solo con lector en la salida)
+	SessionTable sessions;
+	bool exitByCard = false;
+
+	// Cajones libres y reservas, compartidos por todos los carriles
+	SlotInventory inventory;
+	// Reservas de autos que ya pasaron la pluma y todavía no presionaron un
+	// switch: vencen a los PARK_RESERVATION_TIMEOUT_MS o al salir su sesión
+	struct ParkReservation
+	{
+		uint32_t sinceMs;
+		int session;
+		bool active;
+	};
+	ParkReservation parkReservations[SLOTS_COUNT] = {};
+
+	char lastUid[UID_TEXT_LEN] = "--";
+	// Última distancia filtrada de cada carril (cm)
+	float laneDistance[LANE_MAX] = {};
+	char entryTime[SLOTS_COUNT][TIME_TEXT_LEN];
+	char exitTime[SLOTS_COUNT][TIME_TEXT_LEN];
+
+	// Historial multi-resolución de lecturas del ultrasónico de todos los
+	// carriles (/api/history?lane=)
+	DistanceHistory distanceHistory;
+	// Cuantiles de los tiempos observados (/api/getParams)
+	AutoTuner tuner;
+	// Eventos para el collector y último estado de pluma registrado por carril
+	EventLog eventLog;
+	bool laneRaisedLogged[LANE_MAX] = {};
+};
+
+#endif // PARKING_CONTROLLER_H
@@ -0,0 +1,77 @@
+// =====================================================================
+// PLANIFICADOR DE LECTORES RFID EN EL BUS SPI COMPARTIDO
+// =====================================================================
+//
+// Cada llamada a service() ejecuta un solo paso (HalRfidReader::poll) del
+// siguiente lector listo, en round-robin. Un lector está listo si tiene
+// una transacción en curso o si pasó RFID_COOLDOWN desde su última
+// consulta. Así una tarjeta lenta en un lector ocupa el bus de a un paso
+// por vuelta y los demás lectores se atienden entre medio.
+//
+// Métricas por lector: pasos ejecutados (tasa de consulta), duración de
+// cada paso (tiempo de bus), espera de turno estando listo y latencia de
+// lectura (primer paso con tarjeta -> UID completo).
+
+#ifndef RFID_SCHEDULER_H
+#define RFID_SCHEDULER_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include "config.h"
+#include "hal.h"
+#include "gate.h"
+
+struct RfidReaderStats
+{
+	uint32_t polls = 0;
+	uint32_t cards = 0;
+	uint64_t pollTotalUs = 0;
+	uint32_t pollMaxUs = 0;
+	uint32_t waitMaxMs = 0;
+	GateLatency read;
+
+	uint32_t pollMeanUs() const { return polls ? (uint32_t)(pollTotalUs / polls) : 0; }
+};
+
+class RfidScheduler
+{
+public:
+	// Registrar el lector de un carril; false si ya hay LANE_MAX
+	bool add(HalRfidReader &reader, uint8_t lane, uint32_t nowMs);
+	// Un paso del siguiente lector listo. Devuelve el carril cuyo lector
+	// entregó un UID en este paso, -1 si ninguno
+	int service(HalClock &clock, char *uid, size_t len);
+
+	int count() const { return readerCount; }
+	uint8_t lane(int i) const { return readers[i].lane; }
+	const RfidReaderStats &stats(int i) const { return readers[i].stats; }
+	// Pasos por minuto del lector i desde que se registró
+	uint32_t pollsPerMinute(int i, uint32_t nowMs) const;
+	// Próximo instante en que service() consultará algún lector
+	// (nowMs si hay una transacción en curso o una consulta vencida)
+	uint32_t nextDueMs(uint32_t nowMs) const;
+
+private:
+	struct Entry
+	{
+		HalRfidReader *reader = nullptr;
+		uint8_t lane = 0;
+		// Transacción en curso (hay que volver a llamar) y si ya se vio tarjeta
+		bool active = false;
+		bool reading = false;
+		// Próxima consulta en reposo, desde cuándo está listo e inicio de la lectura
+		uint32_t dueMs = 0;
+		uint32_t readyMs = 0;
+		uint32_t readStartMs = 0;
+		uint32_t addedMs = 0;
+		RfidReaderStats stats;
+	};
+
+	Entry readers[LANE_MAX];
+	int readerCount = 0;
+	// Siguiente lector a considerar (round-robin)
+	int cursor = 0;
+};
+
+#endif // RFID_SCHEDULER_H
@@ -0,0 +1,73 @@
+// =====================================================================
+// PERFIL DE MOVIMIENTO DEL SERVO (trapecio de velocidad)
+// =====================================================================
+//
+// Genera la posición de la pluma en cada instante: acelera hasta
+// SERVO_SPEED_DEG_S, avanza a velocidad constante y frena antes del
+// destino (o un triángulo si el recorrido es corto). Un cambio de destino
+// a mitad de camino parte de la velocidad actual: si la pluma iba en
+// sentido contrario (reversa por obstáculo) primero frena hasta
+// detenerse, así la velocidad nunca cambia más que la aceleración.
+// Posiciones en centésimas de grado y tiempo en ms, todo con enteros.
+// En el ESP32 update() se llama desde un timer en segundo plano que
+// escribe el PWM (LEDC); en el simulador lo llama el lazo de simulación.
+
+#ifndef SERVO_MOTION_H
+#define SERVO_MOTION_H
+
+#include <stdint.h>
+
+#include "config.h"
+
+class ServoMotion
+{
+public:
+	ServoMotion(uint16_t speedDegS = SERVO_SPEED_DEG_S, uint16_t accelDegS2 = SERVO_ACCEL_DEG_S2);
+
+	// Fijar la posición sin trayectoria (arranque)
+	void setPosition(int angle);
+	// Iniciar trayectoria hacia angle desde la posición y velocidad actuales
+	void moveTo(int angle, uint32_t nowMs);
+	// Avanzar el perfil; devuelve la posición en centésimas de grado
+	int32_t update(uint32_t nowMs);
+
+	bool isMoving() const { return moving; }
+	int targetAngle() const { return target / 100; }
+	int32_t positionCentiDeg() const { return position; }
+	// Velocidad con signo (centésimas de grado / s) en el último update()
+	int32_t velocityCentiDegS() const { return velocity; }
+	// Duración planificada del movimiento actual (ms)
+	uint32_t plannedMs() const { return totalMs; }
+	// true una sola vez cuando el movimiento llega al destino
+	bool takeArrived();
+
+private:
+	int32_t speed; // centésimas de grado / s
+	int32_t accel; // centésimas de grado / s^2
+
+	int32_t position = 0;
+	int32_t velocity = 0;
+	int32_t start = 0;
+	int32_t target = 0;
+	uint32_t startMs = 0;
+
+	// Frenado previo: velocidad con la que venía y cuánto tarda en detenerse
+	int32_t brakeSpeed = 0;
+	uint32_t brakeMs = 0;
+	// Trapecio hacia el destino: desde dónde, sentido y velocidad inicial
+	int32_t rampStart = 0;
+	int32_t direction = 1;
+	int32_t initialSpeed = 0;
+
+	// Tramos del perfil (ms) y velocidad pico alcanzada
+	uint32_t accelMs = 0;
+	uint32_t cruiseMs = 0;
+	uint32_t decelMs = 0;
+	uint32_t totalMs = 0;
+	int32_t peakSpeed = 0;
+
+	bool moving = false;
+	bool arrived = false;
+};
+
+#endif // SERVO_MOTION_H
@@ -0,0 +1,42 @@
+// =====================================================================
+// SESIONES DE ESTACIONAMIENTO (entrada -> salida)
+// =====================================================================
+//
+// Cuando la salida tiene lector RFID, cada tarjeta admitida en una entrada
+// abre una sesión y la pluma de salida solo abre con la tarjeta de una
+// sesión abierta, que se cierra al salir. Una tarjeta con sesión abierta
+// no puede volver a entrar (anti-passback).
+
+#ifndef SESSION_TABLE_H
+#define SESSION_TABLE_H
+
+#include <stdint.h>
+
+#include "config.h"
+
+// Tamaño del texto de UID (igual que UID_TEXT_LEN del controlador)
+#define SESSION_UID_LEN 24
+
+struct ParkingSession
+{
+	char uid[SESSION_UID_LEN];
+	uint32_t entryMs;
+	bool open;
+};
+
+class SessionTable
+{
+public:
+	// Abrir una sesión para uid; -1 si la tabla está llena
+	int open(const char *uid, uint32_t nowMs);
+	// Índice de la sesión abierta de uid, -1 si no tiene
+	int find(const char *uid) const;
+	void close(int i);
+	int count() const;
+	const ParkingSession &at(int i) const { return sessions[i]; }
+
+private:
+	ParkingSession sessions[SESSION_MAX] = {};
+};
+
+#endif // SESSION_TABLE_H
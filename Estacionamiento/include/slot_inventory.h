@@ -0,0 +1,88 @@
+// =====================================================================
+// INVENTARIO DE CAJONES COMPARTIDO ENTRE CARRILES
+// =====================================================================
+//
+// "Disponibles" = cajones libres menos reservas. Una tarjeta válida en
+// cualquier carril de entrada reserva un lugar con una sola operación
+// atómica (compare-and-swap): si dos carriles compiten por el último
+// cajón, solo uno obtiene la reserva y el otro ve LLENO. La reserva se
+// consume cuando el auto presiona el switch de un cajón, o se devuelve
+// si la pluma baja por timeout sin que pase ningún auto. Si el auto pasó
+// pero no estaciona, ParkingController la devuelve cuando vence o cuando
+// sale con su tarjeta.
+
+#ifndef SLOT_INVENTORY_H
+#define SLOT_INVENTORY_H
+
+#include <atomic>
+
+#include "config.h"
+
+class SlotInventory
+{
+public:
+	explicit SlotInventory(int slots = SLOTS_COUNT) : total(slots), freeSlots(slots) {}
+
+	// Reservar un lugar para un auto autorizado; false si no queda ninguno
+	bool tryReserve()
+	{
+		int current = freeSlots.load();
+		while (current > 0)
+		{
+			if (freeSlots.compare_exchange_weak(current, current - 1))
+			{
+				reserved.fetch_add(1);
+				return true;
+			}
+		}
+		return false;
+	}
+
+	// Devolver una reserva que no se usó (timeout de la pluma o reserva vencida)
+	void release()
+	{
+		if (takeReservation())
+			freeSlots.fetch_add(1);
+	}
+
+	// Un cajón se ocupó: consume una reserva o, si no había, un lugar libre
+	void occupy()
+	{
+		if (takeReservation())
+			return;
+		int current = freeSlots.load();
+		while (current > 0 && !freeSlots.compare_exchange_weak(current, current - 1))
+		{
+		}
+	}
+
+	// Un cajón se liberó
+	void vacate()
+	{
+		int current = freeSlots.load();
+		while (current + reserved.load() < total && !freeSlots.compare_exchange_weak(current, current + 1))
+		{
+		}
+	}
+
+	int available() const { return freeSlots.load(); }
+	int reservations() const { return reserved.load(); }
+
+private:
+	bool takeReservation()
+	{
+		int current = reserved.load();
+		while (current > 0)
+		{
+			if (reserved.compare_exchange_weak(current, current - 1))
+				return true;
+		}
+		return false;
+	}
+
+	const int total;
+	std::atomic<int> freeSlots;
+	std::atomic<int> reserved{0};
+};
+
+#endif // SLOT_INVENTORY_H
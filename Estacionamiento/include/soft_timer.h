@@ -0,0 +1,39 @@
+// =====================================================================
+// TEMPORIZADOR NO BLOQUEANTE SOBRE HalClock
+// =====================================================================
+//
+// Misma semántica que noDelay (start/update/setdelay), pero recibe el
+// tiempo actual en lugar de llamar a millis(), para que la lógica corra
+// igual en el ESP32 y en el simulador con reloj virtual.
+
+#ifndef SOFT_TIMER_H
+#define SOFT_TIMER_H
+
+#include <stdint.h>
+
+class SoftTimer
+{
+public:
+	explicit SoftTimer(uint32_t delayMs = 1000) : delay(delayMs) {}
+
+	void setdelay(uint32_t delayMs) { delay = delayMs; }
+	uint32_t getdelay() const { return delay; }
+	void start(uint32_t nowMs) { previousMs = nowMs; }
+
+	// true cuando pasó el delay desde el último start/update; se rearma solo
+	bool update(uint32_t nowMs)
+	{
+		if (nowMs - previousMs >= delay)
+		{
+			previousMs = nowMs;
+			return true;
+		}
+		return false;
+	}
+
+private:
+	uint32_t delay;
+	uint32_t previousMs = 0;
+};
+
+#endif // SOFT_TIMER_H
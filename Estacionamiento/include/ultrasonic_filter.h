@@ -0,0 +1,67 @@
+// =====================================================================
+// FILTRO DEL SENSOR ULTRASÓNICO (punto fijo)
+// =====================================================================
+//
+// Pipeline por cada eco:
+//   1. Validación de rango (se descartan ecos fuera de [MIN, MAX] mm)
+//   2. Mediana de las últimas N duraciones (microsegundos enteros)
+//   3. EMA en Q8 sobre la mediana
+//   4. Histéresis: "presente" al bajar de ENTER_MM, "libre" al superar EXIT_MM
+// Un solo eco ruidoso no cambia el estado: necesita dominar la mediana y
+// además arrastrar la EMA más allá del umbral.
+
+#ifndef ULTRASONIC_FILTER_H
+#define ULTRASONIC_FILTER_H
+
+#include <stdint.h>
+
+#include "config.h"
+
+// Tamaño máximo de ventana soportado para la mediana
+#define ULTRASONIC_MEDIAN_MAX 9
+
+class UltrasonicFilter
+{
+public:
+	UltrasonicFilter(uint8_t medianN = ULTRASONIC_MEDIAN_N,
+					 uint16_t alphaQ8 = ULTRASONIC_EMA_ALPHA_Q8,
+					 uint16_t enterMm = ULTRASONIC_ENTER_MM,
+					 uint16_t exitMm = ULTRASONIC_EXIT_MM);
+
+	// Olvidar el estado (nueva pasada de vehículo)
+	void reset();
+
+	// Procesar un eco; devuelve false si la lectura se descartó
+	bool addEcho(uint32_t durationUs);
+
+	// Estado con histéresis: true = hay vehículo frente al sensor
+	bool present() const { return isPresent; }
+	// Distancia filtrada (EMA) en mm; 0 si aún no hay lecturas válidas
+	uint16_t filteredMm() const;
+	// Última lectura válida sin filtrar en mm
+	uint16_t lastRawMm() const { return rawMm; }
+	// Hay algo cerca (para muestreo adaptativo)
+	bool isNear(uint16_t nearMm) const { return isPresent || (primed && filteredMm() < nearMm); }
+
+	// Conversión entera de duración de eco a mm
+	static uint16_t echoToMm(uint32_t durationUs);
+
+private:
+	uint32_t median() const;
+
+	uint8_t windowSize;
+	uint16_t alpha;
+	uint16_t enterThresholdMm;
+	uint16_t exitThresholdMm;
+
+	uint32_t window[ULTRASONIC_MEDIAN_MAX];
+	uint8_t windowCount = 0;
+	uint8_t windowHead = 0;
+
+	uint32_t emaUsQ8 = 0; // EMA de la duración en us, escalada por 256
+	bool primed = false;
+	bool isPresent = false;
+	uint16_t rawMm = 0;
+};
+
+#endif // ULTRASONIC_FILTER_H
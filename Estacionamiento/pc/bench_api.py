@@ -0,0 +1,225 @@
+"""
+Benchmark de la API HTTP - Estacionamiento Inteligente
+
+Características:
+- Varios clientes concurrentes (dashboards, collector, GUI) contra las rutas del firmware
+- Mezcla configurable de peticiones (getStatus / getParams / setParams)
+- Reporta req/s, latencia p50/p99 por ruta y la latencia del lazo de control
+  (/api/loopStats) medida al mismo tiempo
+- Guarda los resultados en JSON y los compara contra una línea base
+
+Uso típico contra el simulador nativo (pio run -e native):
+    python pc/bench_api.py --spawn-sim .pio/build/native/program --clients 1,4,8 \
+        --output bench/baselines/native.json
+    python pc/bench_api.py --spawn-sim .pio/build/native/program --compare bench/baselines/native.json
+
+También puede apuntar al ESP32 real con --url http://192.168.100.91
+"""
+
+import argparse
+import json
+import os
+import random
+import subprocess
+import sys
+import threading
+import time
+from datetime import datetime
+
+import requests
+
+DEFAULT_URL = "http://127.0.0.1:8080"
+DEFAULT_MIX = "getStatus=70,getParams=20,setParams=10"
+REQUEST_TIMEOUT = 5  # segundos
+
+
+def parse_mix(text):
+    """Convertir 'ruta=peso,...' en lista de (ruta, peso)"""
+    mix = []
+    for part in text.split(","):
+        route, weight = part.split("=")
+        mix.append((route.strip(), int(weight)))
+    return mix
+
+
+def percentile(values, p):
+    """Percentil por rango más cercano (values ya ordenado)"""
+    if not values:
+        return 0.0
+    idx = max(0, min(len(values) - 1, int(round(p / 100.0 * len(values) + 0.5)) - 1))
+    return values[idx]
+
+
+def get_loop_stats(url, reset=False):
+    """Leer /api/loopStats; None si el firmware no lo expone"""
+    try:
+        res = requests.get(f"{url}/api/loopStats", params={"reset": "1"} if reset else None, timeout=REQUEST_TIMEOUT)
+        if res.status_code == 200:
+            return res.json()
+    except Exception:
+        pass
+    return None
+
+
+def client_worker(url, mix, params, deadline, results, lock, seed):
+    """Un cliente: elige rutas según la mezcla hasta el deadline"""
+    rng = random.Random(seed)
+    routes = [r for r, _ in mix]
+    weights = [w for _, w in mix]
+    local = []
+    while time.monotonic() < deadline:
+        route = rng.choices(routes, weights)[0]
+        start = time.perf_counter()
+        ok = False
+        try:
+            if route == "setParams":
+                # Reenviar los valores actuales para no alterar la configuración
+                res = requests.post(f"{url}/api/setParams", json=params, timeout=REQUEST_TIMEOUT)
+            else:
+                res = requests.get(f"{url}/api/{route}", timeout=REQUEST_TIMEOUT)
+            ok = res.status_code == 200
+        except Exception:
+            ok = False
+        local.append((route, (time.perf_counter() - start) * 1000.0, ok))
+    with lock:
+        results.extend(local)
+
+
+def run_level(url, clients, duration, mix, params):
+    """Ejecutar un nivel de carga y devolver su resumen"""
+    get_loop_stats(url, reset=True)
+    results = []
+    lock = threading.Lock()
+    deadline = time.monotonic() + duration
+    threads = [
+        threading.Thread(target=client_worker, args=(url, mix, params, deadline, results, lock, i), daemon=True)
+        for i in range(clients)
+    ]
+    start = time.monotonic()
+    for t in threads:
+        t.start()
+    for t in threads:
+        t.join()
+    elapsed = time.monotonic() - start
+    loop = get_loop_stats(url)
+
+    ok_lat = sorted(ms for _, ms, ok in results if ok)
+    level = {
+        "clients": clients,
+        "requests": len(results),
+        "errors": sum(1 for _, _, ok in results if not ok),
+        "req_s": round(len(ok_lat) / elapsed, 1) if elapsed > 0 else 0.0,
+        "p50_ms": round(percentile(ok_lat, 50), 2),
+        "p99_ms": round(percentile(ok_lat, 99), 2),
+        "routes": {},
+        "loop": loop,
+    }
+    for route, _ in mix:
+        lat = sorted(ms for r, ms, ok in results if r == route and ok)
+        level["routes"][route] = {
+            "requests": len(lat),
+            "p50_ms": round(percentile(lat, 50), 2),
+            "p99_ms": round(percentile(lat, 99), 2),
+        }
+    return level
+
+
+def print_level(level):
+    loop = level["loop"]
+    loop_text = (f"lazo p50 {loop['p50_us'] / 1000:.2f} ms p99 {loop['p99_us'] / 1000:.2f} ms "
+                 f"máx {loop['max_us'] / 1000:.2f} ms") if loop else "lazo: sin /api/loopStats"
+    print(f"[BENCH] {level['clients']:3d} clientes | {level['req_s']:8.1f} req/s | "
+          f"p50 {level['p50_ms']:7.2f} ms | p99 {level['p99_ms']:7.2f} ms | "
+          f"errores {level['errors']} | {loop_text}")
+
+
+def compare(results, baseline, tolerance):
+    """Comparar contra una línea base; devuelve lista de regresiones"""
+    regressions = []
+    base_levels = {lvl["clients"]: lvl for lvl in baseline.get("levels", [])}
+    for lvl in results["levels"]:
+        base = base_levels.get(lvl["clients"])
+        if not base:
+            continue
+        limit = 1.0 + tolerance / 100.0
+        checks = [
+            ("req/s", base["req_s"], lvl["req_s"], lvl["req_s"] * limit < base["req_s"]),
+            ("p99_ms", base["p99_ms"], lvl["p99_ms"], lvl["p99_ms"] > base["p99_ms"] * limit),
+        ]
+        if lvl.get("loop") and base.get("loop"):
+            checks.append(("lazo p99_us", base["loop"]["p99_us"], lvl["loop"]["p99_us"],
+                           lvl["loop"]["p99_us"] > base["loop"]["p99_us"] * limit))
+        for name, old, new, bad in checks:
+            if bad:
+                regressions.append(f"{lvl['clients']} clientes: {name} {old} -> {new}")
+    return regressions
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Benchmark de la API HTTP del estacionamiento")
+    parser.add_argument("--url", default=DEFAULT_URL, help="URL base del firmware o del simulador")
+    parser.add_argument("--clients", default="1,4,8", help="niveles de clientes concurrentes, ej. 1,4,8")
+    parser.add_argument("--duration", type=float, default=10.0, help="segundos por nivel")
+    parser.add_argument("--mix", default=DEFAULT_MIX, help="mezcla de rutas con pesos")
+    parser.add_argument("--output", help="guardar resultados en este JSON (ej. bench/baselines/native.json)")
+    parser.add_argument("--compare", help="JSON de línea base para detectar regresiones")
+    parser.add_argument("--tolerance", type=float, default=20.0, help="tolerancia de regresión en %%")
+    parser.add_argument("--spawn-sim", help="ruta al binario de [env:native]; se lanza con --serve")
+    parser.add_argument("--port", type=int, default=8080, help="puerto para --spawn-sim")
+    parser.add_argument("--traffic-rate", type=int, default=300,
+                        help="autos por hora que genera el simulador de --spawn-sim (0 = sin tráfico)")
+    args = parser.parse_args()
+
+    sim = None
+    url = args.url
+    if args.spawn_sim:
+        url = f"http://127.0.0.1:{args.port}"
+        # Tráfico continuo de fondo para que el control tenga trabajo real: con
+        # el reloj real de --serve, un --synthetic-day apenas llegaría a cada nivel
+        sim = subprocess.Popen([args.spawn_sim, "--serve", str(args.port), "--traffic-rate", str(args.traffic_rate)],
+                               stdout=subprocess.DEVNULL)
+        time.sleep(0.5)
+
+    try:
+        params = requests.get(f"{url}/api/getParams", timeout=REQUEST_TIMEOUT).json()
+        mix = parse_mix(args.mix)
+        results = {
+            "meta": {
+                "url": url,
+                "target": "native" if args.spawn_sim else "device",
+                "mix": args.mix,
+                "duration_s": args.duration,
+                "traffic_rate": args.traffic_rate if args.spawn_sim else None,
+                "date": datetime.now().strftime("%Y-%m-%d %H:%M:%S"),
+            },
+            "levels": [],
+        }
+        for clients in [int(c) for c in args.clients.split(",")]:
+            level = run_level(url, clients, args.duration, mix, params)
+            print_level(level)
+            results["levels"].append(level)
+    finally:
+        if sim:
+            sim.terminate()
+            sim.wait()
+
+    if args.output:
+        os.makedirs(os.path.dirname(args.output) or ".", exist_ok=True)
+        with open(args.output, "w") as f:
+            json.dump(results, f, indent=2)
+        print(f"[BENCH] Resultados guardados en {args.output}")
+
+    if args.compare:
+        with open(args.compare) as f:
+            baseline = json.load(f)
+        regressions = compare(results, baseline, args.tolerance)
+        if regressions:
+            print("[BENCH] Regresiones respecto a la línea base:")
+            for r in regressions:
+                print(f"  - {r}")
+            sys.exit(1)
+        print("[BENCH] Sin regresiones respecto a la línea base")
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,171 @@
+"""
+Benchmark de latencia de punta a punta - Estacionamiento Inteligente
+
+Mide cuánto tarda un cambio de cajón en llegar del firmware a la GUI:
+- Lanza el simulador nativo (--serve) como controlador de reemplazo, con una
+  traza que ocupa y libera cajones cada --period ms
+- Corre el poll del collector (collector.py) contra él y guarda los eventos en MySQL
+- Lee la tabla eventos como lo hace la GUI y calcula la latencia por etapa
+  (latencia.py): firmware -> API, HTTP, collector -> BD, BD -> GUI
+- Reporta p50/p95/máx por etapa y eventos perdidos; guarda JSON con --output
+
+Uso típico (requiere la BD de pc/setup_db.py):
+    python pc/bench_latencia.py --spawn-sim .pio/build/native/program --duration 60
+    python pc/bench_latencia.py --spawn-sim .pio/build/native/program --poll-interval 0.5 \
+        --output bench/latencia_native.json
+
+También puede apuntar al ESP32 real con --url (los eventos los generan los autos reales)
+"""
+
+import argparse
+import json
+import os
+import subprocess
+import tempfile
+import threading
+import time
+from datetime import datetime
+
+import mysql.connector
+
+import collector
+from latencia import ETAPAS, etapas_evento, resumen
+
+
+def escribir_traza(path, duracion_s, periodo_ms, cajones):
+    """Traza para el simulador: cada periodo_ms cambia un cajón (alternando)"""
+    ocupado = [False] * cajones
+    with open(path, "w") as f:
+        f.write("# Generada por pc/bench_latencia.py\n")
+        f.write("0 dist 2500\n")
+        t = periodo_ms
+        n = 0
+        while t < duracion_s * 1000:
+            cajon = n % cajones
+            ocupado[cajon] = not ocupado[cajon]
+            f.write(f"{t} slot {cajon + 1} {1 if ocupado[cajon] else 0}\n")
+            t += periodo_ms
+            n += 1
+
+
+def ultimo_id_eventos():
+    """Mayor id de la tabla eventos (se miden solo los que llegan después)"""
+    conn = mysql.connector.connect(**collector.DB_CONFIG)
+    cursor = conn.cursor()
+    cursor.execute("SELECT COALESCE(MAX(id), 0) FROM eventos")
+    (ultimo,) = cursor.fetchone()
+    conn.close()
+    return ultimo
+
+
+def gui_worker(desde_id, intervalo, deadline, muestras):
+    """Imitar el refresco de la GUI: leer filas nuevas cada intervalo"""
+    ultimo = desde_id
+    while time.monotonic() < deadline:
+        try:
+            conn = mysql.connector.connect(**collector.DB_CONFIG)
+            cursor = conn.cursor(dictionary=True)
+            cursor.execute("SELECT * FROM eventos WHERE id > %s ORDER BY id ASC", (ultimo,))
+            filas = cursor.fetchall()
+            conn.close()
+            visto = time.time()
+            for fila in filas:
+                etapas = etapas_evento(fila, visto)
+                etapas["boot"] = fila["boot"]
+                etapas["seq"] = fila["seq"]
+                muestras.append(etapas)
+                ultimo = fila["id"]
+        except Exception as e:
+            print(f"[BENCH] Error al leer eventos: {e}")
+        time.sleep(intervalo)
+
+
+def print_resumen(res, eventos, perdidos):
+    print(f"[BENCH] {eventos} eventos medidos, {perdidos} sin llegar a la BD")
+    for clave, nombre in ETAPAS + [("total", "Total")]:
+        r = res[clave]
+        print(f"[BENCH] {nombre:16s} p50 {r['p50_ms']:8.1f} ms | p95 {r['p95_ms']:8.1f} ms | máx {r['max_ms']:8.1f} ms")
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Latencia de punta a punta de los eventos del estacionamiento")
+    parser.add_argument("--url", default="http://127.0.0.1:8081", help="URL base del firmware o del simulador")
+    parser.add_argument("--spawn-sim", help="ruta al binario de [env:native]; se lanza con --serve")
+    parser.add_argument("--port", type=int, default=8081, help="puerto para --spawn-sim")
+    parser.add_argument("--duration", type=float, default=30.0, help="segundos de medición")
+    parser.add_argument("--period", type=int, default=1500, help="ms entre cambios de cajón del simulador")
+    parser.add_argument("--poll-interval", type=float, default=collector.POLL_INTERVAL,
+                        help="segundos entre consultas del collector")
+    parser.add_argument("--gui-interval", type=float, default=2.0, help="segundos entre lecturas de la GUI")
+    parser.add_argument("--output", help="guardar resultados en este JSON")
+    args = parser.parse_args()
+
+    sim = None
+    traza = None
+    url = args.url.rstrip("/")
+    if args.spawn_sim:
+        url = f"http://127.0.0.1:{args.port}"
+        fd, traza = tempfile.mkstemp(suffix=".trace")
+        os.close(fd)
+        escribir_traza(traza, args.duration, args.period, 2)
+        sim = subprocess.Popen([args.spawn_sim, "--serve", str(args.port), "--trace", traza],
+                               stdout=subprocess.DEVNULL)
+        time.sleep(0.5)
+
+    muestras = []
+    try:
+        collector.crear_tabla()
+        desde_id = ultimo_id_eventos()
+        collector.ESP32_URL = url
+        collector.POLL_INTERVAL = args.poll_interval
+        collector.running = True
+        poll = threading.Thread(target=collector.poll_esp32, daemon=True)
+        poll.start()
+
+        # La GUI sigue leyendo un poco más para recoger los últimos eventos
+        deadline = time.monotonic() + args.duration + args.poll_interval + args.gui_interval
+        gui = threading.Thread(target=gui_worker, args=(desde_id, args.gui_interval, deadline, muestras), daemon=True)
+        gui.start()
+        gui.join()
+        collector.running = False
+    finally:
+        if sim:
+            sim.terminate()
+            sim.wait()
+        if traza:
+            os.remove(traza)
+
+    if not muestras:
+        print("[BENCH] No llegó ningún evento a la BD")
+        return
+    # Huecos en la secuencia de cada arranque: eventos que se pisaron en el firmware o no se guardaron
+    perdidos = 0
+    for boot in set(m["boot"] for m in muestras):
+        seqs = set(m["seq"] for m in muestras if m["boot"] == boot)
+        perdidos += max(seqs) - min(seqs) + 1 - len(seqs)
+    res = resumen(muestras)
+    print_resumen(res, len(muestras), perdidos)
+
+    if args.output:
+        resultados = {
+            "meta": {
+                "url": url,
+                "target": "native" if args.spawn_sim else "device",
+                "duration_s": args.duration,
+                "period_ms": args.period,
+                "poll_interval_s": args.poll_interval,
+                "gui_interval_s": args.gui_interval,
+                "date": datetime.now().strftime("%Y-%m-%d %H:%M:%S"),
+            },
+            "events": len(muestras),
+            "lost": perdidos,
+            "stages": res,
+        }
+        os.makedirs(os.path.dirname(args.output) or ".", exist_ok=True)
+        with open(args.output, "w") as f:
+            json.dump(resultados, f, indent=2)
+        print(f"[BENCH] Resultados guardados en {args.output}")
+
+
+if __name__ == "__main__":
+    main()
@@ -6,8 +6,15 @@ Características:
 - Almacenamiento en MySQL local
 - Sincronización con BD local en tiempo real
 - Manejo de conexiones múltiples (si es necesario)
+- Eventos del firmware (/api/events) con sus sellos de tiempo por etapa,
+  para medir la latencia sensor -> API -> collector -> BD -> GUI
+
+Contra el simulador nativo en lugar del ESP32:
+    .pio/build/native/program --serve 8080 --traffic-rate 120
+    python pc/collector.py --url http://127.0.0.1:8080
 """
 
+import argparse
 import socket
 import threading
 import mysql.connector
@@ -21,6 +28,7 @@ ESP32_IP = "192.168.100.91"  # IP del ESP32
 ESP32_PORT = 80  # Puerto del webserver
 COLLECTOR_PORT = 5000  # Puerto TCP del collector
 POLL_INTERVAL = 2  # segundos entre consultas al ESP32
+ESP32_URL = f"http://{ESP32_IP}:{ESP32_PORT}"  # --url la reemplaza (p. ej. el simulador)
 
 DB_CONFIG = {
     'host': 'localhost',
@@ -32,6 +40,30 @@ DB_CONFIG = {
 # Flag global para threads
 running = True
 
+# Un evento del firmware por fila; seq vuelve a 1 en cada arranque de la
+# placa y boot dice a cuál pertenece. Tiempos de la PC en segundos epoch:
+#   pc_envio / pc_recepcion: petición a /api/events enviada / respuesta recibida
+#   bd_insercion: NOW(3) de MySQL al insertar (la BD corre en esta misma PC)
+# fw_ms es el millis() de la detección y fw_espera_ms lo que esperó el evento
+# en el firmware hasta la respuesta (incluye la espera al siguiente poll).
+SQL_TABLA_EVENTOS = """
+CREATE TABLE IF NOT EXISTS eventos (
+    id INT AUTO_INCREMENT PRIMARY KEY,
+    boot INT UNSIGNED,
+    seq INT UNSIGNED,
+    tipo VARCHAR(8),
+    indice TINYINT,
+    valor TINYINT,
+    fw_ms BIGINT,
+    fw_espera_ms INT,
+    pc_envio DOUBLE,
+    pc_recepcion DOUBLE,
+    bd_insercion DOUBLE,
+    INDEX idx_boot_seq (boot, seq),
+    INDEX idx_bd_insercion (bd_insercion)
+)
+"""
+
 def crear_tabla():
     """Crear tabla de lecturas si no existe"""
     try:
@@ -56,8 +88,9 @@ def crear_tabla():
             INDEX idx_cajon2 (cajon2)
         )
         """)
+        cursor.execute(SQL_TABLA_EVENTOS)
         conn.commit()
-        print("[DB] Tabla verificada/creada")
+        print("[DB] Tablas verificadas/creadas")
         conn.close()
     except Exception as e:
         print(f"[DB] Error al crear tabla: {e}")
@@ -92,6 +125,64 @@ def guardar_lectura(data):
         print(f"[DB] Error al guardar: {e}")
         return False
 
+def guardar_eventos(data, pc_envio, pc_recepcion):
+    """Guardar los eventos de una respuesta de /api/events con sus sellos de tiempo"""
+    eventos = data.get("events", [])
+    if not eventos:
+        return True
+    try:
+        conn = mysql.connector.connect(**DB_CONFIG)
+        cursor = conn.cursor()
+        sql = """
+        INSERT INTO eventos
+        (boot, seq, tipo, indice, valor, fw_ms, fw_espera_ms, pc_envio, pc_recepcion, bd_insercion)
+        VALUES (%s, %s, %s, %s, %s, %s, %s, %s, %s, UNIX_TIMESTAMP(NOW(3)))
+        """
+        boot = data.get("boot")
+        cursor.executemany(sql, [
+            (boot, e["seq"], e["type"], e["i"], e["v"], e["t"], e["age"], pc_envio, pc_recepcion)
+            for e in eventos
+        ])
+        conn.commit()
+        conn.close()
+        return True
+    except Exception as e:
+        print(f"[DB] Error al guardar eventos: {e}")
+        return False
+
+def reinicio_detectado(estado, boot, now_ms):
+    """La placa arrancó de nuevo si cambió su boot o si su millis() retrocedió"""
+    if boot != estado["boot"]:
+        return True
+    return estado["now_ms"] is not None and now_ms is not None and now_ms < estado["now_ms"]
+
+def leer_eventos(url, estado):
+    """Pedir todos los eventos posteriores a estado["seq"] y actualizar estado (seq, boot, now_ms)"""
+    while True:
+        pc_envio = time.time()
+        res = requests.get(f"{url}/api/events", params={"since": estado["seq"]}, timeout=5)
+        pc_recepcion = time.time()
+        data = res.json()
+        boot = data.get("boot")
+        now_ms = data.get("nowMs")
+        if reinicio_detectado(estado, boot, now_ms):
+            # La secuencia volvió a 1: se vuelve a pedir desde el principio
+            print(f"[POLL] La placa se reinició (boot {estado['boot']} -> {boot}); leyendo eventos desde seq 1")
+            pedido = estado["seq"]
+            estado.update(seq=0, boot=boot, now_ms=None)
+            if pedido != 0:
+                continue
+        estado["now_ms"] = now_ms
+        if data.get("lost"):
+            print(f"[POLL] {data['lost']} eventos se perdieron en el firmware (poll demasiado lento)")
+        if not guardar_eventos(data, pc_envio, pc_recepcion):
+            return
+        eventos = data.get("events", [])
+        if eventos:
+            estado["seq"] = eventos[-1]["seq"]
+        if not data.get("more"):
+            return
+
 def handle_client(conn, addr):
     """Manejar conexión TCP de cliente (si la hay)"""
     print(f"[TCP] Cliente conectado: {addr}")
@@ -130,18 +221,36 @@ def tcp_server():
 
 def poll_esp32():
     """Consultar ESP32 periódicamente y guardar datos"""
-    print(f"[POLL] Iniciando consulta a ESP32 ({ESP32_IP}) cada {POLL_INTERVAL}s")
+    print(f"[POLL] Iniciando consulta a ESP32 ({ESP32_URL}) cada {POLL_INTERVAL}s")
+    # Los eventos anteriores al arranque del collector no se guardan: su espera
+    # en el firmware no representa la latencia del pipeline
+    estado = None
     while running:
         try:
-            res = requests.get(f"http://{ESP32_IP}/api/getStatus", timeout=5)
+            res = requests.get(f"{ESP32_URL}/api/getStatus", timeout=5)
             data = res.json()
             guardar_lectura(data)
+            seq = data.get("seq")
+            # Solo se piden eventos si el firmware registró alguno nuevo o se reinició
+            # (el boot cambia aunque el seq nuevo coincida con el anterior)
+            if estado is None:
+                if seq is not None:
+                    estado = {"seq": seq, "boot": data.get("boot"), "now_ms": None}
+            elif seq != estado["seq"] or data.get("boot") != estado["boot"]:
+                leer_eventos(ESP32_URL, estado)
         except Exception as e:
             print(f"[POLL] Error al consultar ESP32: {e}")
         
         time.sleep(POLL_INTERVAL)
 
 if __name__ == "__main__":
+    parser = argparse.ArgumentParser(description="Recolector de datos del estacionamiento")
+    parser.add_argument("--url", default=ESP32_URL, help="URL base del ESP32 o del simulador (--serve)")
+    parser.add_argument("--interval", type=float, default=POLL_INTERVAL, help="segundos entre consultas")
+    args = parser.parse_args()
+    ESP32_URL = args.url.rstrip("/")
+    POLL_INTERVAL = args.interval
+
     print("=" * 60)
     print("SUBSISTEMA DE RECOLECCIÓN DE DATOS")
     print("=" * 60)
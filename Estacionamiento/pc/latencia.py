@@ -0,0 +1,52 @@
+"""
+Latencia por etapa de los eventos del firmware (tabla eventos)
+
+Un cambio de cajón, tarjeta o pluma recorre:
+  firmware  : detección -> respuesta de /api/events (incluye esperar el poll)
+  http      : respuesta armada -> recibida por el collector (mitad del RTT, estimado)
+  collector : respuesta recibida -> fila insertada en MySQL
+  gui       : fila insertada -> la GUI la lee de la BD
+Los tiempos de la PC salen del mismo reloj (collector, MySQL y GUI corren
+en la misma máquina); el del firmware es su propio millis(), así que no
+hace falta sincronizar relojes.
+"""
+
+ETAPAS = [
+    ("firmware", "Firmware → API"),
+    ("http", "HTTP"),
+    ("collector", "Collector → BD"),
+    ("gui", "BD → GUI"),
+]
+
+
+def etapas_evento(fila, gui_visto):
+    """Latencia en ms de cada etapa de una fila de eventos leída en gui_visto (epoch s)"""
+    etapas = {
+        "firmware": float(fila["fw_espera_ms"]),
+        "http": (fila["pc_recepcion"] - fila["pc_envio"]) * 1000.0 / 2.0,
+        "collector": (fila["bd_insercion"] - fila["pc_recepcion"]) * 1000.0,
+        "gui": (gui_visto - fila["bd_insercion"]) * 1000.0,
+    }
+    etapas["total"] = sum(etapas.values())
+    return etapas
+
+
+def percentil(valores, p):
+    """Percentil por rango más cercano (valores ya ordenado)"""
+    if not valores:
+        return 0.0
+    idx = max(0, min(len(valores) - 1, int(round(p / 100.0 * len(valores) + 0.5)) - 1))
+    return valores[idx]
+
+
+def resumen(muestras):
+    """p50/p95/máx por etapa (y total) de una lista de resultados de etapas_evento"""
+    res = {}
+    for clave in [c for c, _ in ETAPAS] + ["total"]:
+        valores = sorted(m[clave] for m in muestras)
+        res[clave] = {
+            "p50_ms": round(percentil(valores, 50), 1),
+            "p95_ms": round(percentil(valores, 95), 1),
+            "max_ms": round(valores[-1], 1) if valores else 0.0,
+        }
+    return res
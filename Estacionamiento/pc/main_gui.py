@@ -7,6 +7,7 @@ Características:
 - Representación gráfica del estacionamiento
 - Estadísticas con gráficos por período
 - Actualización en tiempo real desde BD local
+- Latencia por etapa de cada evento (firmware -> API -> collector -> BD -> GUI)
 """
 
 import tkinter as tk
@@ -18,12 +19,17 @@ import matplotlib.pyplot as plt
 from matplotlib.backends.backend_tkagg import FigureCanvasTkAgg
 from matplotlib.figure import Figure
 from datetime import datetime, timedelta
+from collections import deque
 import time
 
+from latencia import ETAPAS, etapas_evento, resumen
+
 # Configuración
 ESP32_IP = "192.168.100.91" # IP del ESP32
 ESP32_PORT = 80 # Puerto del webserver
 
+LATENCIA_MUESTRAS = 200 # Eventos recientes que se grafican
+
 DB_CONFIG = {
     'host': 'localhost',
     'user': 'root',
@@ -39,6 +45,9 @@ class EstacionamientoGUI:
         
         self.esp32_url = f"http://{ESP32_IP}:{ESP32_PORT}"
         self.update_running = True
+        # Latencias de los eventos leídos de la BD; solo los que llegan con la GUI abierta
+        self.latencias = deque(maxlen=LATENCIA_MUESTRAS)
+        self.ultimo_evento_id = None
         
         # Crear interfaz
         self.create_widgets()
@@ -68,6 +77,11 @@ class EstacionamientoGUI:
         self.notebook.add(self.tab_stats, text="Estadísticas")
         self.create_stats_tab()
         
+        # Pestaña 4: Latencia del pipeline de eventos
+        self.tab_latencia = ttk.Frame(self.notebook)
+        self.notebook.add(self.tab_latencia, text="Latencia")
+        self.create_latencia_tab()
+        
         # Frame inferior con botones de control
         self.frame_control = ttk.Frame(self.root)
         self.frame_control.pack(fill=tk.X, padx=10, pady=5)
@@ -166,6 +180,18 @@ class EstacionamientoGUI:
         self.canvas_stats = tk.Canvas(self.tab_stats, bg="white")
         self.canvas_stats.pack(fill=tk.BOTH, expand=True, padx=10, pady=10)
         
+    def create_latencia_tab(self):
+        """Pestaña de latencia por etapa"""
+        frame_controls = ttk.LabelFrame(self.tab_latencia, text="Eventos del firmware (tabla eventos)", padding=10)
+        frame_controls.pack(fill=tk.X, padx=10, pady=10)
+        
+        ttk.Button(frame_controls, text="Actualizar Gráfico", command=self.update_latencia).pack(side=tk.LEFT, padx=5)
+        self.lbl_latencia = ttk.Label(frame_controls, text="Sin eventos todavía", font=("Arial", 9))
+        self.lbl_latencia.pack(side=tk.LEFT, padx=10)
+        
+        self.canvas_latencia = tk.Canvas(self.tab_latencia, bg="white")
+        self.canvas_latencia.pack(fill=tk.BOTH, expand=True, padx=10, pady=10)
+        
     def draw_parking(self):
         """Dibujar representación gráfica del estacionamiento"""
         self.canvas.delete("all")
@@ -235,6 +261,82 @@ class EstacionamientoGUI:
         except Exception as e:
             print(f"Error al obtener estado de BD: {e}")
             
+    def refresh_eventos_from_db(self):
+        """Leer eventos nuevos de la BD y calcular su latencia por etapa"""
+        try:
+            conn = mysql.connector.connect(**DB_CONFIG)
+            cursor = conn.cursor(dictionary=True)
+            if self.ultimo_evento_id is None:
+                # Al abrir la GUI: medir solo desde ahora
+                cursor.execute("SELECT COALESCE(MAX(id), 0) AS id FROM eventos")
+                self.ultimo_evento_id = cursor.fetchone()["id"]
+                conn.close()
+                return
+            cursor.execute("SELECT * FROM eventos WHERE id > %s ORDER BY id ASC", (self.ultimo_evento_id,))
+            filas = cursor.fetchall()
+            conn.close()
+            visto = time.time()
+            for fila in filas:
+                etapas = etapas_evento(fila, visto)
+                etapas["seq"] = fila["seq"]
+                etapas["tipo"] = fila["tipo"]
+                self.latencias.append(etapas)
+                self.ultimo_evento_id = fila["id"]
+            if filas:
+                total = resumen(list(self.latencias))["total"]
+                self.lbl_latencia.config(text=f"{len(self.latencias)} eventos | total p50 {total['p50_ms']:.0f} ms, "
+                                              f"p95 {total['p95_ms']:.0f} ms, máx {total['max_ms']:.0f} ms")
+        except Exception as e:
+            print(f"Error al obtener eventos de BD: {e}")
+            
+    def update_latencia(self):
+        """Graficar la latencia por etapa de los eventos recientes"""
+        muestras = list(self.latencias)
+        if not muestras:
+            messagebox.showwarning("Sin datos", "No llegaron eventos desde que se abrió la GUI")
+            return
+        try:
+            fig = Figure(figsize=(12, 4), dpi=100)
+            
+            # Gráfico 1: barras apiladas por evento (cuánto aportó cada etapa)
+            ax1 = fig.add_subplot(121)
+            x = range(len(muestras))
+            base = [0.0] * len(muestras)
+            for clave, nombre in ETAPAS:
+                valores = [m[clave] for m in muestras]
+                ax1.bar(x, valores, bottom=base, label=nombre)
+                base = [b + v for b, v in zip(base, valores)]
+            ax1.set_title("Latencia por evento")
+            ax1.set_xlabel("Evento (más reciente a la derecha)")
+            ax1.set_ylabel("ms")
+            ax1.legend()
+            ax1.grid(True, alpha=0.3)
+            
+            # Gráfico 2: p50 y p95 de cada etapa
+            ax2 = fig.add_subplot(122)
+            res = resumen(muestras)
+            nombres = [nombre for _, nombre in ETAPAS] + ["Total"]
+            claves = [clave for clave, _ in ETAPAS] + ["total"]
+            pos = range(len(claves))
+            ax2.barh([p - 0.2 for p in pos], [res[c]["p50_ms"] for c in claves], height=0.4, label="p50")
+            ax2.barh([p + 0.2 for p in pos], [res[c]["p95_ms"] for c in claves], height=0.4, label="p95")
+            ax2.set_yticks(list(pos))
+            ax2.set_yticklabels(nombres)
+            ax2.invert_yaxis()
+            ax2.set_title(f"Percentiles por etapa ({len(muestras)} eventos)")
+            ax2.set_xlabel("ms")
+            ax2.legend()
+            ax2.grid(True, alpha=0.3)
+            
+            fig.tight_layout()
+            
+            self.canvas_latencia.delete("all")
+            canvas = FigureCanvasTkAgg(fig, master=self.canvas_latencia)
+            canvas.draw()
+            self.canvas_latencia.create_window(0, 0, window=canvas.get_tk_widget(), anchor=tk.NW)
+        except Exception as e:
+            messagebox.showerror("Error", f"Error al generar gráfico de latencia: {e}")
+            
     def cargar_parametros(self):
         """Cargar parámetros desde ESP32"""
         try:
@@ -336,6 +438,7 @@ class EstacionamientoGUI:
         while self.update_running:
             try:
                 self.refresh_estado_from_db()
+                self.refresh_eventos_from_db()
                 time.sleep(2)
             except:
                 time.sleep(2)
@@ -347,6 +450,7 @@ class EstacionamientoGUI:
                 conn = mysql.connector.connect(**DB_CONFIG)
                 cursor = conn.cursor()
                 cursor.execute("DELETE FROM lecturas")
+                cursor.execute("DELETE FROM eventos")
                 conn.commit()
                 conn.close()
                 messagebox.showinfo("Éxito", "BD limpiada correctamente")
@@ -28,8 +28,26 @@ try:
             INDEX idx_cajon2 (cajon2)
         )
     """)
+    # Eventos del firmware con sus sellos de tiempo (igual que en collector.py)
+    cursor.execute("""
+        CREATE TABLE IF NOT EXISTS estacionamiento.eventos (
+            id INT AUTO_INCREMENT PRIMARY KEY,
+            boot INT UNSIGNED,
+            seq INT UNSIGNED,
+            tipo VARCHAR(8),
+            indice TINYINT,
+            valor TINYINT,
+            fw_ms BIGINT,
+            fw_espera_ms INT,
+            pc_envio DOUBLE,
+            pc_recepcion DOUBLE,
+            bd_insercion DOUBLE,
+            INDEX idx_boot_seq (boot, seq),
+            INDEX idx_bd_insercion (bd_insercion)
+        )
+    """)
     conn.commit()
-    print("[OK] Base de datos y tabla creadas correctamente")
+    print("[OK] Base de datos y tablas creadas correctamente")
     conn.close()
 except Exception as e:
     print(f"[ERROR] {e}")
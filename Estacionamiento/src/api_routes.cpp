@@ -0,0 +1,311 @@
+#include "api_routes.h"
+
+#include <stdio.h>
+#include <ArduinoJson.h>
+
+// getParams: 3 parámetros y "learned" (percentil + 6 campos por parámetro).
+// JSON_OBJECT_SIZE cuenta los miembros con el tamaño de la plataforma
+// (16 bytes en el ESP32, 32 en el simulador de 64 bits)
+#define PARAMS_DOC_SIZE (JSON_OBJECT_SIZE(4) + JSON_OBJECT_SIZE(3) + 2 * JSON_OBJECT_SIZE(6))
+// getStatus: 9 campos fijos y 3 por cajón (con la clave copiada, ~12 bytes),
+// más un objeto de hasta 11 campos por carril
+#define STATUS_DOC_SIZE                                                 \
+	(JSON_OBJECT_SIZE(9 + 3 * SLOTS_COUNT) + 3 * SLOTS_COUNT * 12 + \
+	 JSON_ARRAY_SIZE(LANE_MAX) + LANE_MAX * JSON_OBJECT_SIZE(11))
+// setParams: solo las claves ajustables (las claves se copian del cuerpo)
+#define SET_PARAMS_KEYS 3
+#define SET_PARAMS_DOC_SIZE (JSON_OBJECT_SIZE(SET_PARAMS_KEYS) + 64)
+
+static const char *const JSON_DOC_NAMES[JSON_DOC_COUNT] = {
+	"getStatus", "getParams", "setParams", "loopStats", "diag", "memory", "configFile", "rfid", "events"};
+static ApiJsonUsage jsonUsage[JSON_DOC_COUNT] = {};
+
+void api_recordJsonUsage(uint8_t docId, size_t used, size_t capacity)
+{
+	if (docId >= JSON_DOC_COUNT)
+		return;
+	jsonUsage[docId].capacity = capacity;
+	if (used > jsonUsage[docId].peak)
+		jsonUsage[docId].peak = used;
+}
+
+const ApiJsonUsage &api_jsonUsage(uint8_t docId)
+{
+	return jsonUsage[docId < JSON_DOC_COUNT ? docId : 0];
+}
+
+// Anotar el uso del documento y serializarlo. Si no entró completo en el
+// documento o no cabe en `out`, 500 en vez de mandar JSON truncado
+static int finishJson(JsonDocument &doc, uint8_t docId, char *out, size_t len)
+{
+	api_recordJsonUsage(docId, doc.memoryUsage(), doc.capacity());
+	if (doc.overflowed() || measureJson(doc) >= len)
+	{
+		snprintf(out, len, "{\"error\":\"response too large\"}");
+		return 500;
+	}
+	serializeJson(doc, out, len);
+	return 200;
+}
+
+// Throughput (pasadas/h) y latencias de cada carril: ciclo completo de la
+// pluma y tiempo desde la orden de subir hasta que queda abierta
+static void addLanes(JsonArray arr, const ParkingController &controller)
+{
+	for (int i = 0; i < controller.laneCount(); i++)
+	{
+		const Gate &gate = controller.lane(i);
+		JsonObject lane = arr.createNestedObject();
+		lane["name"] = gate.name();
+		lane["kind"] = gate.isEntry() ? "entry" : "exit";
+		lane["phase"] = gate.phase();
+		lane["raised"] = gate.isRaised();
+		if (gate.hasDetector())
+			lane["distancia"] = controller.lastDistanceCm(i);
+		lane["passes"] = gate.passes();
+		lane["perHour"] = gate.passesPerHour();
+		lane["timeouts"] = gate.timeouts();
+		lane["cycleAvgMs"] = gate.cycle().meanMs();
+		lane["cycleMaxMs"] = gate.cycle().maxMs;
+		lane["openAvgMs"] = gate.openLatency().meanMs();
+	}
+}
+
+int api_getStatus(ParkingController &controller, char *out, size_t len)
+{
+	DynamicJsonDocument doc(STATUS_DOC_SIZE);
+	doc["rfidUID"] = controller.latestRFIDUID();
+	doc["distancia"] = controller.lastDistanceCm();
+	doc["plumaEntrada"] = controller.isEntranceBarrierRaised();
+	doc["plumaSalida"] = controller.isExitBarrierRaised();
+	char key[16];
+	for (int i = 0; i < SLOTS_COUNT; i++)
+	{
+		snprintf(key, sizeof(key), "cajon%d", i + 1);
+		doc[key] = controller.isSlotOccupied(i);
+	}
+	// Agregar timestamps de entrada/salida
+	for (int i = 0; i < SLOTS_COUNT; i++)
+	{
+		snprintf(key, sizeof(key), "entryTime%d", i + 1);
+		doc[key] = controller.lastEntryTime(i);
+		snprintf(key, sizeof(key), "exitTime%d", i + 1);
+		doc[key] = controller.lastExitTime(i);
+	}
+	// Cajones libres sin reservar y reservas de autos que todavía no estacionaron
+	doc["disponibles"] = controller.getAvailableSlots();
+	doc["reservados"] = controller.getReservedSlots();
+	addLanes(doc.createNestedArray("lanes"), controller);
+	// Último evento registrado: el collector pide /api/events solo si cambió
+	// (o si cambió el arranque, porque la secuencia empieza de nuevo)
+	doc["seq"] = controller.events().lastSeq();
+	doc["boot"] = controller.events().bootId();
+	return finishJson(doc, JSON_DOC_STATUS, out, len);
+}
+
+static void addLearned(JsonObject obj, const LearnedParam &param, bool autoTune)
+{
+	obj["value"] = param.valueMs();
+	obj["quantileMs"] = param.quantileMs();
+	obj["samples"] = param.samples();
+	// Aproximaciones sin auto (timeouts): no entran al percentil
+	obj["noShows"] = param.censored();
+	// Confianza con 2 decimales
+	obj["confidence"] = (int)(param.confidence() * 100 + 0.5f) / 100.0f;
+	// En uso en lugar del valor manual
+	obj["applied"] = autoTune && param.ready();
+}
+
+int api_getParams(ParkingController &controller, char *out, size_t len)
+{
+	DynamicJsonDocument doc(PARAMS_DOC_SIZE);
+	// Valores manuales (los que se guardan); los aprendidos van aparte
+	doc["SALIDA_DELAY_MS"] = controller.salidaDelayMs;
+	doc["ULTRASONIC_TIMEOUT_MS"] = controller.ultrasonicTimeoutMs;
+	doc["AUTO_TUNE"] = controller.autoTune;
+	// Valores aprendidos y su confianza (se informan aunque AUTO_TUNE esté apagado)
+	JsonObject learned = doc.createNestedObject("learned");
+	learned["percentile"] = AUTOTUNE_PERCENTILE;
+	addLearned(learned.createNestedObject("SALIDA_DELAY_MS"), controller.learned().passage, controller.autoTune);
+	addLearned(learned.createNestedObject("ULTRASONIC_TIMEOUT_MS"), controller.learned().approach, controller.autoTune);
+	return finishJson(doc, JSON_DOC_PARAMS, out, len);
+}
+
+int api_setParams(ParkingController &controller, const char *body, char *out, size_t len)
+{
+	if (!body || !body[0])
+	{
+		snprintf(out, len, "{\"error\":\"no body\"}");
+		return 400;
+	}
+	// Solo se leen las claves ajustables: el cuerpo puede ser la respuesta
+	// completa de getParams, con el bloque "learned" incluido
+	StaticJsonDocument<JSON_OBJECT_SIZE(SET_PARAMS_KEYS)> filter;
+	filter["SALIDA_DELAY_MS"] = true;
+	filter["ULTRASONIC_TIMEOUT_MS"] = true;
+	filter["AUTO_TUNE"] = true;
+	DynamicJsonDocument doc(SET_PARAMS_DOC_SIZE);
+	DeserializationError err = deserializeJson(doc, body, DeserializationOption::Filter(filter));
+	if (err)
+	{
+		snprintf(out, len, "{\"error\":\"invalid json\"}");
+		return 400;
+	}
+	api_recordJsonUsage(JSON_DOC_SET_PARAMS, doc.memoryUsage(), doc.capacity());
+	if (doc.containsKey("SALIDA_DELAY_MS"))
+		controller.salidaDelayMs = doc["SALIDA_DELAY_MS"];
+	if (doc.containsKey("ULTRASONIC_TIMEOUT_MS"))
+		controller.ultrasonicTimeoutMs = doc["ULTRASONIC_TIMEOUT_MS"];
+	if (doc.containsKey("AUTO_TUNE"))
+		controller.autoTune = doc["AUTO_TUNE"];
+	// Con AUTO_TUNE se usan los aprendidos que estén listos; los manuales quedan guardados
+	controller.applyParams();
+	snprintf(out, len, "{\"ok\":true}");
+	return 200;
+}
+
+int api_getLoopStats(LatencyHistogram &loopStats, bool reset, char *out, size_t len)
+{
+	DynamicJsonDocument doc(256);
+	doc["n"] = loopStats.count();
+	doc["p50_us"] = loopStats.percentileUs(50);
+	doc["p99_us"] = loopStats.percentileUs(99);
+	doc["max_us"] = loopStats.maxUs();
+	int code = finishJson(doc, JSON_DOC_LOOP_STATS, out, len);
+	if (reset)
+		loopStats.reset();
+	return code;
+}
+
+static void addStalls(JsonObject obj, const WatchdogRecord &rec)
+{
+	for (uint8_t i = 0; i < STAGE_COUNT; i++)
+	{
+		JsonObject stage = obj.createNestedObject(LoopWatchdog::stageName(i));
+		stage["count"] = rec.stalls[i];
+		stage["longestMs"] = rec.longestStallMs[i];
+	}
+}
+
+int api_getDiag(const LoopWatchdog &watchdog, uint32_t nowMs, const char *resetReason, char *out, size_t len)
+{
+	DynamicJsonDocument doc(3072);
+	const WatchdogRecord &rec = watchdog.current();
+	doc["uptimeMs"] = nowMs;
+	doc["bootCount"] = rec.bootCount;
+	doc["watchdogRestarts"] = rec.restarts;
+	doc["resetReason"] = resetReason;
+	doc["stage"] = LoopWatchdog::stageName(rec.stage);
+	doc["stageMs"] = nowMs - rec.stageStartMs;
+	addStalls(doc.createNestedObject("stalls"), rec);
+
+	// Arranque anterior: etapa activa al terminar y los últimos sucesos
+	// ([t, tipo, etapa, índice, valor], ver CrumbKind)
+	if (watchdog.hasPrevious())
+	{
+		const WatchdogRecord &last = watchdog.previous();
+		JsonObject prev = doc.createNestedObject("previous");
+		prev["watchdogRestart"] = last.restartRequested != 0;
+		prev["stage"] = LoopWatchdog::stageName(last.stage);
+		prev["stageStartMs"] = last.stageStartMs;
+		if (last.restartRequested)
+			prev["stalledMs"] = last.restartStalledMs;
+		JsonArray crumbs = prev.createNestedArray("breadcrumbs");
+		for (uint8_t i = 0; i < last.crumbCount; i++)
+		{
+			const Breadcrumb &crumb = LoopWatchdog::crumbAt(last, i);
+			JsonArray item = crumbs.createNestedArray();
+			item.add(crumb.tMs);
+			item.add(LoopWatchdog::crumbName(crumb.kind));
+			item.add(LoopWatchdog::stageName(crumb.stage));
+			item.add(crumb.index);
+			item.add(crumb.value);
+		}
+		addStalls(prev.createNestedObject("stalls"), last);
+	}
+	return finishJson(doc, JSON_DOC_DIAG, out, len);
+}
+
+int api_getMemory(const MemoryDiag &memory, char *out, size_t len)
+{
+	DynamicJsonDocument doc(2048);
+	const MemorySample &sample = memory.last();
+	doc["freeHeap"] = sample.freeHeap;
+	doc["minFreeHeap"] = sample.minFreeHeap;
+	doc["largestBlock"] = sample.largestBlock;
+	doc["fragmentationPct"] = memory.fragmentationPct();
+	doc["level"] = MemoryDiag::levelName(memory.level());
+	doc["shedRequests"] = memory.shedCount();
+	// Bytes de pila que nunca se llegaron a usar, por tarea
+	JsonObject stacks = doc.createNestedObject("stackFree");
+	for (uint8_t i = 0; i < memory.taskCount(); i++)
+		stacks[memory.task(i).name] = memory.task(i).freeBytes;
+	// Pico de uso de cada documento JSON contra su capacidad
+	JsonObject docs = doc.createNestedObject("json");
+	for (uint8_t i = 0; i < JSON_DOC_COUNT; i++)
+	{
+		JsonArray usage = docs.createNestedArray(JSON_DOC_NAMES[i]);
+		usage.add(jsonUsage[i].peak);
+		usage.add(jsonUsage[i].capacity);
+	}
+	return finishJson(doc, JSON_DOC_MEMORY, out, len);
+}
+
+int api_getRfid(const ParkingController &controller, uint32_t nowMs, char *out, size_t len)
+{
+	DynamicJsonDocument doc(1536);
+	const RfidScheduler &sched = controller.readers();
+	doc["exitRequiresCard"] = controller.exitRequiresCard();
+	doc["openSessions"] = controller.openSessions();
+	JsonArray readers = doc.createNestedArray("readers");
+	for (int i = 0; i < sched.count(); i++)
+	{
+		const RfidReaderStats &st = sched.stats(i);
+		JsonObject reader = readers.createNestedObject();
+		reader["lane"] = controller.lane(sched.lane(i)).name();
+		reader["polls"] = st.polls;
+		reader["pollsPerMin"] = sched.pollsPerMinute(i, nowMs);
+		reader["pollAvgUs"] = st.pollMeanUs();
+		reader["pollMaxUs"] = st.pollMaxUs;
+		reader["waitMaxMs"] = st.waitMaxMs;
+		reader["cards"] = st.cards;
+		reader["readAvgMs"] = st.read.meanMs();
+		reader["readMaxMs"] = st.read.maxMs;
+	}
+	return finishJson(doc, JSON_DOC_RFID, out, len);
+}
+
+int api_getEvents(const ParkingController &controller, uint32_t sinceSeq, uint32_t nowMs, char *out, size_t len)
+{
+	DynamicJsonDocument doc(2048);
+	const EventLog &log = controller.events();
+	uint32_t last = log.lastSeq();
+	uint32_t first = sinceSeq + 1;
+	// La secuencia volvió a empezar (reinicio de la placa): mandar todo lo que hay
+	if (sinceSeq > last)
+		first = 1;
+	uint32_t oldest = log.oldestSeq();
+	doc["boot"] = log.bootId();
+	doc["nowMs"] = nowMs;
+	doc["seq"] = last;
+	// Eventos que se pisaron antes de que el collector los pidiera
+	doc["lost"] = (oldest && first < oldest) ? oldest - first : 0;
+	if (oldest && first < oldest)
+		first = oldest;
+	JsonArray events = doc.createNestedArray("events");
+	uint32_t seq = first;
+	for (int n = 0; seq <= last && n < EVENT_RESPONSE_MAX; seq++, n++)
+	{
+		const LoggedEvent *e = log.find(seq);
+		JsonObject evt = events.createNestedObject();
+		evt["seq"] = e->seq;
+		evt["t"] = e->tMs;
+		// Espera en el firmware hasta esta respuesta (aritmética de millis, sin desborde)
+		evt["age"] = nowMs - e->tMs;
+		evt["type"] = EventLog::typeName(e->type);
+		evt["i"] = e->index;
+		evt["v"] = e->value;
+	}
+	doc["more"] = seq <= last;
+	return finishJson(doc, JSON_DOC_EVENTS, out, len);
+}
@@ -0,0 +1,23 @@
+#include "auto_tuner.h"
+
+LearnedParam::LearnedParam(int minMs, int maxMs)
+	: quantile(AUTOTUNE_PERCENTILE / 100.0f), minMs(minMs), maxMs(maxMs)
+{
+}
+
+int LearnedParam::valueMs() const
+{
+	uint32_t value = quantileMs() * (100 + AUTOTUNE_MARGIN_PCT) / 100;
+	if (value < (uint32_t)minMs)
+		return minMs;
+	if (value > (uint32_t)maxMs)
+		return maxMs;
+	return (int)value;
+}
+
+float LearnedParam::confidence() const
+{
+	if (samples() >= AUTOTUNE_FULL_CONFIDENCE_SAMPLES)
+		return 1.0f;
+	return (float)samples() / AUTOTUNE_FULL_CONFIDENCE_SAMPLES;
+}
@@ -0,0 +1,142 @@
+#include "distance_history.h"
+
+#include <string.h>
+
+void DistanceHistory::openBucket(DistanceBucket &b, uint32_t tMs, uint16_t mm)
+{
+	b.tMs = tMs;
+	b.minMm = mm;
+	b.maxMm = mm;
+	b.sumMm = mm;
+	b.count = 1;
+}
+
+void DistanceHistory::accumulate(DistanceBucket &b, uint16_t mm)
+{
+	if (mm < b.minMm)
+		b.minMm = mm;
+	if (mm > b.maxMm)
+		b.maxMm = mm;
+	b.sumMm += mm;
+	b.count++;
+}
+
+template <size_t N>
+void DistanceHistory::addTo(HistoryRing<DistanceBucket, N> &ring, DistanceBucket *open, uint8_t &openMask,
+							uint32_t start, uint16_t mm, uint8_t lane)
+{
+	// Todos los abiertos son del mismo período: si cambió, se cierran juntos
+	// (en orden de carril) para que el anillo siga ordenado por tiempo
+	if (openMask && open[__builtin_ctz(openMask)].tMs != start)
+	{
+		for (uint8_t i = 0; i < LANE_MAX; i++)
+		{
+			if (openMask & (1u << i))
+				ring.push(open[i]);
+		}
+		openMask = 0;
+	}
+	if (openMask & (1u << lane))
+	{
+		accumulate(open[lane], mm);
+		return;
+	}
+	openBucket(open[lane], start, mm);
+	open[lane].lane = lane;
+	openMask |= (1u << lane);
+}
+
+void DistanceHistory::add(uint32_t nowMs, uint16_t mm, uint8_t lane)
+{
+	raw.push({nowMs, mm, lane});
+	addTo(seconds, openSecond, openSeconds, nowMs - (nowMs % 1000UL), mm, lane);
+	addTo(minutes, openMinute, openMinutes, nowMs - (nowMs % 60000UL), mm, lane);
+}
+
+size_t DistanceHistory::openCount(uint8_t openMask)
+{
+	return (size_t)__builtin_popcount(openMask);
+}
+
+// k-ésimo bucket abierto en orden de carril
+DistanceBucket DistanceHistory::openAt(const DistanceBucket *open, uint8_t openMask, size_t k)
+{
+	for (uint8_t i = 0; i < LANE_MAX; i++)
+	{
+		if ((openMask & (1u << i)) && k-- == 0)
+			return open[i];
+	}
+	return open[0];
+}
+
+size_t DistanceHistory::count(HistoryResolution res) const
+{
+	switch (res)
+	{
+	case HISTORY_RAW:
+		return raw.size();
+	case HISTORY_1S:
+		return seconds.size() + openCount(openSeconds);
+	case HISTORY_1M:
+		return minutes.size() + openCount(openMinutes);
+	}
+	return 0;
+}
+
+DistanceBucket DistanceHistory::bucketAt(HistoryResolution res, size_t i) const
+{
+	if (res == HISTORY_1S)
+		return (i < seconds.size()) ? seconds.at(i) : openAt(openSecond, openSeconds, i - seconds.size());
+	if (res == HISTORY_1M)
+		return (i < minutes.size()) ? minutes.at(i) : openAt(openMinute, openMinutes, i - minutes.size());
+	// RAW: presentar la muestra como bucket de un solo elemento
+	DistanceSample s = raw.at(i);
+	DistanceBucket b;
+	openBucket(b, s.tMs, s.mm);
+	b.lane = s.lane;
+	return b;
+}
+
+uint32_t DistanceHistory::timeAt(HistoryResolution res, size_t i) const
+{
+	if (res == HISTORY_RAW)
+		return raw.at(i).tMs;
+	return bucketAt(res, i).tMs;
+}
+
+size_t DistanceHistory::firstIndexSince(HistoryResolution res, uint32_t sinceMs) const
+{
+	// Los tiempos están ordenados dentro de cada anillo; la resta con signo
+	// mantiene el orden aunque millis() dé la vuelta.
+	size_t lo = 0;
+	size_t hi = count(res);
+	while (lo < hi)
+	{
+		size_t mid = lo + (hi - lo) / 2;
+		if ((int32_t)(timeAt(res, mid) - sinceMs) < 0)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+	return lo;
+}
+
+bool DistanceHistory::parseResolution(const char *text, HistoryResolution &res)
+{
+	if (!text || !*text || strcmp(text, "raw") == 0)
+	{
+		res = HISTORY_RAW;
+		return true;
+	}
+	if (strcmp(text, "1s") == 0)
+	{
+		res = HISTORY_1S;
+		return true;
+	}
+	if (strcmp(text, "1m") == 0)
+	{
+		res = HISTORY_1M;
+		return true;
+	}
+	return false;
+}
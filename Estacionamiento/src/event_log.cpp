@@ -0,0 +1,33 @@
+#include "event_log.h"
+
+static const char *const EVENT_TYPE_NAMES[EVT_TYPE_COUNT] = {"slot", "card", "gate"};
+
+uint32_t EventLog::record(uint8_t type, uint8_t index, uint8_t value, uint32_t nowMs)
+{
+	LoggedEvent &e = ring[nextSeq % EVENT_LOG_CAPACITY];
+	e.seq = nextSeq;
+	e.tMs = nowMs;
+	e.type = type;
+	e.index = index;
+	e.value = value;
+	return nextSeq++;
+}
+
+uint32_t EventLog::oldestSeq() const
+{
+	if (nextSeq <= EVENT_LOG_CAPACITY)
+		return nextSeq > 1 ? 1 : 0;
+	return nextSeq - EVENT_LOG_CAPACITY;
+}
+
+const LoggedEvent *EventLog::find(uint32_t seq) const
+{
+	if (seq == 0 || seq >= nextSeq || seq < oldestSeq())
+		return nullptr;
+	return &ring[seq % EVENT_LOG_CAPACITY];
+}
+
+const char *EventLog::typeName(uint8_t type)
+{
+	return type < EVT_TYPE_COUNT ? EVENT_TYPE_NAMES[type] : "?";
+}
@@ -0,0 +1,240 @@
+#include "gate.h"
+
+void Gate::attach(const LaneConfig &config, HalServo &servo, HalPulseCapture *detector, HalRfidReader *reader)
+{
+	cfg = &config;
+	this->servo = &servo;
+	this->detector = detector;
+	rfid = reader;
+}
+
+void Gate::begin(uint32_t nowMs)
+{
+	servo->setAngle(servoAngle(SERVO_ANGLE_DOWN));
+	target = SERVO_ANGLE_DOWN;
+	raised = false;
+	fullyOpen = false;
+	gatePhase = 0;
+	startedMs = lastUpdateMs = nowMs;
+}
+
+// La pluma se considera levantada desde que empieza a subir hasta el
+// evento "cerrada" del servo, no hasta que se ordena bajarla.
+void Gate::raise(uint32_t nowMs)
+{
+	if (!raised)
+		cycleStartMs = nowMs;
+	raiseCmdMs = nowMs;
+	servo->moveTo(servoAngle(SERVO_ANGLE_UP));
+	target = SERVO_ANGLE_UP;
+	fullyOpen = false;
+	raised = true;
+}
+
+void Gate::lower()
+{
+	servo->moveTo(servoAngle(SERVO_ANGLE_DOWN));
+	target = SERVO_ANGLE_DOWN;
+	fullyOpen = false;
+}
+
+void Gate::setTiming(uint32_t noCarTimeoutMs, uint32_t holdMs)
+{
+	noCarTimer.setdelay(noCarTimeoutMs);
+	this->holdMs = holdMs;
+}
+
+void Gate::admit(uint32_t nowMs)
+{
+	halLogf("[%s] Levantando pluma y esperando auto...\n", cfg->name);
+	raise(nowMs);
+	// Iniciar la lógica de espera: o detecta auto, o timeout
+	gatePhase = 1;
+	carDetectedRecently = false;
+	carCurrentlyDetected = false;
+	passageTiming = false;
+	noCarTimer.start(nowMs);
+	// Nueva pasada: olvidar lecturas anteriores del filtro
+	ultrasonicFilter.reset();
+}
+
+// Secuencia de salida: subir, esperar holdMs con la pluma arriba, bajar
+void Gate::open(uint32_t nowMs)
+{
+	passCount++;
+	if (gatePhase == 2)
+	{
+		// Ya está abierta: extender la espera para el nuevo auto
+		holdStartMs = nowMs;
+		return;
+	}
+	if (gatePhase != 1)
+	{
+		// Inactiva o bajando: subir (de nuevo)
+		raise(nowMs);
+		gatePhase = 1;
+	}
+}
+
+// Eventos "abierta"/"cerrada" del servo: reemplazan las esperas fijas
+uint8_t Gate::handleServoEvent(uint32_t nowMs)
+{
+	if (!servo->takeArrived())
+		return 0;
+	if (target == SERVO_ANGLE_UP)
+	{
+		fullyOpen = true;
+		openMillis = nowMs;
+		openStats.add(nowMs - raiseCmdMs);
+		if (isEntry())
+		{
+			// El timeout para que aparezca el auto corre desde que la pluma está arriba
+			if (gatePhase == 1 && !carDetectedRecently)
+				noCarTimer.start(nowMs);
+		}
+		else if (gatePhase == 1)
+		{
+			// Arriba: empezar a contar la espera
+			gatePhase = 2;
+			holdStartMs = nowMs;
+		}
+		halLogf("[SERVO] Pluma %s abierta\n", cfg->name);
+		return 0;
+	}
+	raised = false;
+	cycleStats.add(nowMs - cycleStartMs);
+	if ((isEntry() && gatePhase == 4) || (!isEntry() && gatePhase == 3))
+		gatePhase = 0;
+	halLogf("[SERVO] Pluma %s cerrada\n", cfg->name);
+	return GATE_EVT_CLOSED;
+}
+
+uint8_t Gate::update(uint32_t nowMs)
+{
+	lastUpdateMs = nowMs;
+	uint8_t events = handleServoEvent(nowMs);
+
+	if (!isEntry())
+	{
+		// Las fases 1 y 3 avanzan con los eventos del servo; aquí solo se
+		// cuenta la espera con la pluma arriba
+		if (gatePhase == 2 && (nowMs - holdStartMs >= holdMs))
+		{
+			lower();
+			gatePhase = 3;
+			events |= GATE_EVT_LOWERING;
+		}
+		return events;
+	}
+
+	if (!raised || gatePhase == 0)
+		return events;
+	// Fase 1: esperando a que pase el auto (el timeout corre con la pluma ya arriba)
+	if (gatePhase == 1 && fullyOpen && noCarTimer.update(nowMs))
+	{
+		timeoutCount++;
+		gatePhase = 3;
+		lowerWaitTimer.start(nowMs);
+		halLogf("[%s] [TIMEOUT] No se detectó auto. Bajando pluma...\n", cfg->name);
+		events |= GATE_EVT_TIMEOUT;
+	}
+	// Fase 3: esperar antes de bajar
+	if (gatePhase == 3 && lowerWaitTimer.update(nowMs))
+	{
+		lower();
+		// Fase 4: bajando hasta el evento "cerrada"
+		gatePhase = 4;
+		ultrasonicTimer.setdelay(ULTRASONIC_FAST_INTERVAL);
+		events |= GATE_EVT_LOWERING;
+	}
+	return events;
+}
+
+uint8_t Gate::checkDetector(uint32_t nowMs)
+{
+	if (!detector || !raised || gatePhase == 0)
+		return 0;
+	if (!ultrasonicTimer.update(nowMs))
+		return 0;
+
+	uint32_t duration = detector->measureEchoUs();
+
+	// Filtrar (mediana + EMA + histéresis); descarta ecos fuera de rango
+	if (!ultrasonicFilter.addEcho(duration))
+	{
+		halLogf("[US] Lectura inválida: %lu us\n", (unsigned long)duration);
+		return 0;
+	}
+	uint8_t events = GATE_EVT_SAMPLE;
+
+	// Muestreo adaptativo: rápido mientras haya algo cerca del sensor o la pluma esté bajando
+	bool fast = ultrasonicFilter.isNear(ULTRASONIC_NEAR_MM) || gatePhase == 4;
+	ultrasonicTimer.setdelay(fast ? ULTRASONIC_FAST_INTERVAL : ULTRASONIC_SLOW_INTERVAL);
+
+	bool carDetected = ultrasonicFilter.present();
+
+	halLogf("[US] %s | Crudo: %u mm | Filtrado: %u mm | Detectado: %d | Fase: %d\n", cfg->name,
+			ultrasonicFilter.lastRawMm(), ultrasonicFilter.filteredMm(), carDetected, gatePhase);
+
+	if (gatePhase == 4 && carDetected)
+	{
+		// Algo quedó bajo la pluma mientras bajaba: volver a subirla
+		halLogf("[US] Obstáculo bajo la pluma %s. Subiendo de nuevo...\n", cfg->name);
+		raise(nowMs);
+		passageTiming = false;
+		gatePhase = 1;
+		carCurrentlyDetected = true;
+		carDetectedRecently = true;
+		return events;
+	}
+
+	if (gatePhase == 1)
+	{
+		// Esperando a que el auto pase
+		if (carDetected)
+		{
+			// Auto detectado (bloqueando sensor)
+			if (!carCurrentlyDetected)
+			{
+				if (!carDetectedRecently)
+				{
+					// Aproximación: desde que la pluma quedó arriba (0 si llegó antes)
+					lastApproachMs = fullyOpen ? nowMs - openMillis : 0;
+					carDetectedMillis = nowMs;
+					passageTiming = true;
+					events |= GATE_EVT_DETECTED;
+				}
+				carCurrentlyDetected = true;
+				carDetectedRecently = true;
+				halLogf("[US] Auto detectado: sensor bloqueado\n");
+			}
+			// Resetear timeout mientras el auto esté siendo detectado
+			noCarTimer.start(nowMs);
+		}
+		if (!carDetected && carCurrentlyDetected && carDetectedRecently)
+		{
+			// Auto pasó: se detectó antes (estaba bloqueado), ahora se fue (desbloqueado)
+			carCurrentlyDetected = false;
+			lastPassageValid = passageTiming;
+			if (passageTiming)
+			{
+				lastPassageMs = nowMs - carDetectedMillis;
+				passageTiming = false;
+			}
+			passCount++;
+			gatePhase = 3; // Bajar después de la espera
+			lowerWaitTimer.start(nowMs);
+			events |= GATE_EVT_PASSED;
+			halLogf("[US] Auto pasó: sensor desbloqueado. Bajando pluma...\n");
+		}
+	}
+	return events;
+}
+
+uint32_t Gate::passesPerHour() const
+{
+	uint32_t elapsed = lastUpdateMs - startedMs;
+	if (elapsed == 0)
+		return 0;
+	return (uint32_t)((uint64_t)passCount * 3600000ULL / elapsed);
+}
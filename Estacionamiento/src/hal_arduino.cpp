@@ -0,0 +1,213 @@
+#include "hal_arduino.h"
+
+#include <stdarg.h>
+#include <time.h>
+
+#include "config.h"
+
+void halLogf(const char *fmt, ...)
+{
+	char buf[160];
+	va_list args;
+	va_start(args, fmt);
+	vsnprintf(buf, sizeof(buf), fmt, args);
+	va_end(args);
+	Serial.print(buf);
+}
+
+// ------------------------- Reloj -------------------------
+
+uint32_t ArduinoClock::millis()
+{
+	return ::millis();
+}
+
+uint32_t ArduinoClock::micros()
+{
+	return ::micros();
+}
+
+// Fecha/hora formateada en ISO-like "YYYY-MM-DD HH:MM:SS"
+bool ArduinoClock::formatWallTime(char *buf, size_t len)
+{
+	time_t now = time(nullptr);
+	struct tm timeinfo;
+	if (!localtime_r(&now, &timeinfo))
+		return false;
+	strftime(buf, len, "%Y-%m-%d %H:%M:%S", &timeinfo);
+	return true;
+}
+
+// ------------------------- GPIO -------------------------
+
+void ArduinoGpio::pinMode(uint8_t pin, uint8_t mode)
+{
+	::pinMode(pin, mode);
+}
+
+void ArduinoGpio::digitalWrite(uint8_t pin, uint8_t level)
+{
+	::digitalWrite(pin, level);
+}
+
+int ArduinoGpio::digitalRead(uint8_t pin)
+{
+	return ::digitalRead(pin);
+}
+
+// ------------------------- Ultrasónico -------------------------
+
+void ArduinoUltrasonic::begin(uint8_t trigPin, uint8_t echoPin)
+{
+	trig = trigPin;
+	echo = echoPin;
+	::pinMode(trig, OUTPUT);
+	::pinMode(echo, INPUT);
+}
+
+uint32_t ArduinoUltrasonic::measureEchoUs()
+{
+	// Generar pulso en TRIG
+	::digitalWrite(trig, LOW);
+	delayMicroseconds(ULTRASONIC_TRIG_PREP_US);
+	::digitalWrite(trig, HIGH);
+	delayMicroseconds(ULTRASONIC_TRIG_PULSE_US);
+	::digitalWrite(trig, LOW);
+
+	// Leer duración del pulso en ECHO
+	return pulseIn(echo, HIGH, ULTRASONIC_PULSE_TIMEOUT_US);
+}
+
+// ------------------------- RFID -------------------------
+
+void ArduinoRfidReader::begin(uint8_t ssPin, uint8_t rstPin)
+{
+	rfid.PCD_Init(ssPin, rstPin);
+}
+
+uint8_t ArduinoRfidReader::poll(char *uid, size_t len)
+{
+	switch (step)
+	{
+	case 0:
+		// REQA: ¿hay una tarjeta nueva en el campo?
+		if (!rfid.PICC_IsNewCardPresent())
+			return RFID_NONE;
+		step = 1;
+		return RFID_PENDING;
+	case 1:
+	{
+		// Anticolisión + SELECT: leer el UID
+		if (!rfid.PICC_ReadCardSerial())
+		{
+			step = 0;
+			return RFID_NONE;
+		}
+		size_t pos = 0;
+		uid[0] = '\0';
+		for (int i = 0; i < rfid.uid.size && pos + 3 < len; i++)
+		{
+			pos += snprintf(uid + pos, len - pos, (i < rfid.uid.size - 1) ? "%02X:" : "%02X", rfid.uid.uidByte[i]);
+		}
+		step = 2;
+		return RFID_CARD;
+	}
+	default:
+		// HALT: liberar la tarjeta y el lector
+		rfid.PICC_HaltA();
+		rfid.PCD_StopCrypto1();
+		step = 0;
+		return RFID_NONE;
+	}
+}
+
+// ------------------------- Servo -------------------------
+
+static uint32_t timerMillis()
+{
+	return (uint32_t)(esp_timer_get_time() / 1000);
+}
+
+void ArduinoServo::begin(uint8_t servoPin, uint8_t ledcChannel)
+{
+	pin = servoPin;
+	channel = ledcChannel;
+	ledcSetup(channel, SERVO_PWM_FREQ, SERVO_PWM_BITS);
+	ledcAttachPin(pin, channel);
+	esp_timer_create_args_t args = {};
+	args.callback = &ArduinoServo::onTick;
+	args.arg = this;
+	args.name = "servo";
+	esp_timer_create(&args, &timer);
+	esp_timer_start_periodic(timer, SERVO_TICK_MS * 1000ULL);
+}
+
+void ArduinoServo::onTick(void *arg)
+{
+	static_cast<ArduinoServo *>(arg)->tick();
+}
+
+void ArduinoServo::tick()
+{
+	portENTER_CRITICAL(&lock);
+	int32_t pos = motion.update(timerMillis());
+	portEXIT_CRITICAL(&lock);
+	if (pos != lastWritten)
+	{
+		writePulse(pos);
+		lastWritten = pos;
+	}
+}
+
+void ArduinoServo::writePulse(int32_t centiDeg)
+{
+	// Ángulo -> ancho de pulso -> duty del periodo de 20 ms
+	uint32_t pulseUs = SERVO_MIN_PULSE_US + (uint32_t)centiDeg * (SERVO_MAX_PULSE_US - SERVO_MIN_PULSE_US) / 18000;
+	uint32_t periodUs = 1000000UL / SERVO_PWM_FREQ;
+	ledcWrite(channel, pulseUs * ((1UL << SERVO_PWM_BITS) - 1) / periodUs);
+}
+
+void ArduinoServo::setAngle(int angle)
+{
+	portENTER_CRITICAL(&lock);
+	motion.setPosition(angle);
+	portEXIT_CRITICAL(&lock);
+}
+
+void ArduinoServo::moveTo(int angle)
+{
+	portENTER_CRITICAL(&lock);
+	motion.moveTo(angle, timerMillis());
+	portEXIT_CRITICAL(&lock);
+}
+
+bool ArduinoServo::takeArrived()
+{
+	portENTER_CRITICAL(&lock);
+	bool arrived = motion.takeArrived();
+	portEXIT_CRITICAL(&lock);
+	return arrived;
+}
+
+// ------------------------- Pantalla -------------------------
+
+void ArduinoDisplay::showMessage(const char *line1, const char *line2)
+{
+	display.clearDisplay();
+	display.setTextSize(1);
+	display.setTextColor(SSD1306_WHITE);
+	display.setCursor(0, 0);
+	display.print(line1);
+	if (line2 && line2[0])
+	{
+		display.setCursor(0, 12);
+		display.print(line2);
+	}
+	display.display();
+}
+
+void ArduinoDisplay::clear()
+{
+	display.clearDisplay();
+	display.display();
+}
@@ -0,0 +1,66 @@
+#include "latency_histogram.h"
+
+// Primer límite: todo lo menor a 16 us cae en el bucket 0
+#define LATENCY_BASE_SHIFT 4
+
+uint8_t LatencyHistogram::bucketFor(uint32_t us)
+{
+	if (us < (1UL << LATENCY_BASE_SHIFT))
+		return 0;
+	// Octava = posición del bit más alto por encima de la base
+	uint8_t msb = 31 - __builtin_clz(us);
+	uint8_t octave = msb - LATENCY_BASE_SHIFT;
+	if (octave >= LATENCY_OCTAVES)
+		return LATENCY_BUCKETS - 1;
+	// Los 2 bits siguientes al más alto eligen el sub-bucket
+	uint8_t sub = (us >> (msb - 2)) & (LATENCY_SUBBUCKETS - 1);
+	return 1 + octave * LATENCY_SUBBUCKETS + sub;
+}
+
+uint32_t LatencyHistogram::bucketUpperUs(uint8_t bucket)
+{
+	if (bucket == 0)
+		return (1UL << LATENCY_BASE_SHIFT) - 1;
+	uint8_t octave = (bucket - 1) / LATENCY_SUBBUCKETS;
+	uint8_t sub = (bucket - 1) % LATENCY_SUBBUCKETS;
+	uint32_t low = 1UL << (octave + LATENCY_BASE_SHIFT);
+	uint32_t step = low / LATENCY_SUBBUCKETS;
+	return low + step * (sub + 1) - 1;
+}
+
+void LatencyHistogram::record(uint32_t us)
+{
+	buckets[bucketFor(us)]++;
+	total++;
+	if (us > maxValue)
+		maxValue = us;
+}
+
+void LatencyHistogram::reset()
+{
+	for (uint8_t i = 0; i < LATENCY_BUCKETS; i++)
+		buckets[i] = 0;
+	total = 0;
+	maxValue = 0;
+}
+
+uint32_t LatencyHistogram::percentileUs(uint8_t p) const
+{
+	if (total == 0)
+		return 0;
+	// Rango (1..total) de la muestra buscada
+	uint32_t rank = (uint32_t)(((uint64_t)total * p + 99) / 100);
+	if (rank == 0)
+		rank = 1;
+	uint32_t seen = 0;
+	for (uint8_t i = 0; i < LATENCY_BUCKETS; i++)
+	{
+		seen += buckets[i];
+		if (seen >= rank)
+		{
+			uint32_t upper = bucketUpperUs(i);
+			return (upper < maxValue) ? upper : maxValue;
+		}
+	}
+	return maxValue;
+}
@@ -0,0 +1,108 @@
+#include "loop_watchdog.h"
+
+#include <string.h>
+
+// Marca de registro válido ("WDOG")
+#define WATCHDOG_MAGIC 0x57444F47UL
+
+static const char *const STAGE_NAMES[STAGE_COUNT] = {
+	"idle", "http", "barriers", "display", "rfid", "ultrasonic", "slots", "fs"};
+static const char *const CRUMB_NAMES[CRUMB_COUNT] = {"stall", "card", "gate", "slot", "fs"};
+
+void LoopWatchdog::begin(WatchdogRecord &rec, uint32_t nowMs)
+{
+	record = &rec;
+	uint32_t bootCount = 0;
+	uint32_t restarts = 0;
+	lastValid = (rec.magic == WATCHDOG_MAGIC);
+	if (lastValid)
+	{
+		last = rec;
+		bootCount = rec.bootCount;
+		restarts = rec.restarts;
+	}
+	memset(&rec, 0, sizeof(rec));
+	rec.magic = WATCHDOG_MAGIC;
+	rec.bootCount = bootCount + 1;
+	rec.restarts = restarts;
+	rec.stage = STAGE_IDLE;
+	rec.stageStartMs = nowMs;
+	seenSeq = 0;
+	seenAtMs = nowMs;
+}
+
+uint8_t LoopWatchdog::enter(uint8_t stage, uint32_t nowMs)
+{
+	WatchdogRecord &rec = *record;
+	uint8_t prev = rec.stage;
+	if (stage == prev)
+		return prev;
+
+	// Cerrar la etapa anterior
+	uint32_t elapsed = nowMs - rec.stageStartMs;
+	if (elapsed >= WATCHDOG_STALL_MS)
+	{
+		rec.stalls[prev]++;
+		if (elapsed > rec.longestStallMs[prev])
+			rec.longestStallMs[prev] = elapsed;
+		note(CRUMB_STALL, prev, elapsed, nowMs);
+	}
+
+	// Primero el inicio y después la etapa: quien lea desde otra tarea
+	// nunca ve la etapa nueva con el inicio viejo
+	rec.stageStartMs = nowMs;
+	rec.stage = stage;
+	rec.seq++;
+	return prev;
+}
+
+void LoopWatchdog::note(uint8_t kind, uint8_t index, uint32_t value, uint32_t nowMs)
+{
+	WatchdogRecord &rec = *record;
+	rec.crumbs[rec.crumbHead] = {nowMs, value, kind, rec.stage, index};
+	rec.crumbHead = (rec.crumbHead + 1) % WATCHDOG_BREADCRUMBS;
+	if (rec.crumbCount < WATCHDOG_BREADCRUMBS)
+		rec.crumbCount++;
+}
+
+bool LoopWatchdog::poll(uint32_t nowMs)
+{
+	if (!record)
+		return false;
+	uint32_t seq = record->seq;
+	if (seq != seenSeq)
+	{
+		seenSeq = seq;
+		seenAtMs = nowMs;
+		return false;
+	}
+	return nowMs - seenAtMs >= WATCHDOG_RESTART_MS;
+}
+
+void LoopWatchdog::markRestart(uint32_t nowMs)
+{
+	WatchdogRecord &rec = *record;
+	rec.restartRequested = 1;
+	rec.restartStalledMs = nowMs - rec.stageStartMs;
+	rec.restarts++;
+	// La etapa colgada también cuenta como bloqueo
+	rec.stalls[rec.stage]++;
+	if (rec.restartStalledMs > rec.longestStallMs[rec.stage])
+		rec.longestStallMs[rec.stage] = rec.restartStalledMs;
+}
+
+const char *LoopWatchdog::stageName(uint8_t stage)
+{
+	return stage < STAGE_COUNT ? STAGE_NAMES[stage] : "?";
+}
+
+const char *LoopWatchdog::crumbName(uint8_t kind)
+{
+	return kind < CRUMB_COUNT ? CRUMB_NAMES[kind] : "?";
+}
+
+const Breadcrumb &LoopWatchdog::crumbAt(const WatchdogRecord &rec, uint8_t index)
+{
+	uint8_t start = (rec.crumbHead + WATCHDOG_BREADCRUMBS - rec.crumbCount) % WATCHDOG_BREADCRUMBS;
+	return rec.crumbs[(start + index) % WATCHDOG_BREADCRUMBS];
+}
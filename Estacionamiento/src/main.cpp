@@ -2,95 +2,60 @@
 #include <Wire.h>
 #include <Adafruit_GFX.h>
 #include <Adafruit_SSD1306.h>
-#include <Servo.h>
 #include <MFRC522.h>
 #include <SPI.h>
-#include <NoDelay.h>
 
 #include "config.h"
+#include "hal_arduino.h"
+#include "parking_controller.h"
+#include "api_routes.h"
+#include "latency_histogram.h"
+#include "loop_watchdog.h"
+#include "memory_diag.h"
+#include "soft_timer.h"
 #include <WiFi.h>
 #include <WebServer.h>
 #include <ArduinoJson.h>
 #include <LittleFS.h>
 #include <time.h>
+#include <esp_system.h>
+#include <esp_timer.h>
+#include <esp_heap_caps.h>
 
 // ==================== VARIABLES GLOBALES ====================
-MFRC522 rfid(RFID_SS_PIN, RFID_RST_PIN);
 Adafruit_SSD1306 display(OLED_WIDTH, OLED_HEIGHT, &Wire, -1);
-Servo barrierServoEntry;
-Servo barrierServoExit;
-
-bool slotOccupied[SLOTS_COUNT] = {false, false};
-bool entranceBarrierRaised = false;
-bool exitBarrierRaised = false;
-bool deniedMessageActive = false;
-bool authorizedMessageActive = false;
-bool timeoutMessageActive = false;
-
-noDelay rfidTimer(RFID_COOLDOWN);
-noDelay ultrasonicTimer(ULTRASONIC_CHECK_INTERVAL);
-noDelay servoTimer(SERVO_TRANSITION_TIME);
-noDelay displayMessageTimer(DISPLAY_MESSAGE_MS);
-noDelay successMessageTimer(SUCCESS_MESSAGE_MS);
-
-noDelay exitRaiseTimer(EXIT_RAISE_MS);
-noDelay exitLowerTimer(EXIT_LOWER_MS);
-bool exitSequenceActive = false;
-int exitPhase = 0; // 0 = INACTIVO, 1 = ESPERANDO PARA SUBIR, 2 = ESPERANDO PARA BAJAR
-unsigned long exitLowerStartMillis = 0;
-bool exitLowerWaiting = false;
-
-// Timeout: si no detecta auto, baja	barrera y cancela acceso
-noDelay ultrasonicNoCarTimer;
-// Esperar antes de bajar
-noDelay lowerBarrierWaitTimer(LOWER_BARRIER_WAIT_MS);
-// Flag: el auto fue detectado alguna vez
-bool carDetectedRecently = false;
-// Flag: el auto está siendo detectado ahora
-bool carCurrentlyDetected = false;
-// 0 = INACTIVO, 1 = ESPERANDO CARRO, 2 = ESPERANDO QUE PASE CARRO, 3 = BAJANDO
-int entranceBarrierPhase = 0;
-
-int availableSlots = SLOTS_COUNT;
-int pendingEntries = 0;
-
-// Declaraciones
-void setupSensors();
-void setupActuators();
-void checkRFID();
-String getCardUID();
-bool isCardAuthorized(String cardUID);
-void handleAuthorizedUser();
-void handleUnauthorizedUser();
-void checkUltrasonicSensor();
-float getUltrasonicDistance();
-void raiseEntranceBarrier();
-void lowerEntranceBarrier();
-void raiseExitBarrier();
-void lowerExitBarrier();
-void checkParkingSlots();
-void updateLED(int slot, bool occupied);
-void displayMessage(String line1, String line2 = "");
-void clearDisplay();
-void updateBarrierLogic();
-void updateDisplayLogic();
-void displayAvailableSlots();
+
+// HAL sobre el hardware real
+ArduinoClock halClock;
+ArduinoGpio halGpio;
+ArduinoDisplay halDisplay(display);
+
+// Carriles (config.h): servo, ultrasónico y lector de cada uno
+static const LaneConfig LANES[LANE_COUNT] = LANE_TABLE;
+ArduinoServo halServos[LANE_COUNT];
+ArduinoUltrasonic halDetectors[LANE_COUNT];
+ArduinoRfidReader halReaders[LANE_COUNT];
+
+// Lógica de plumas y cajones (la misma que corre en [env:native])
+ParkingController controller({halClock, halGpio, halDisplay});
 
 // Web server / FS
 WebServer server(80);
 
-// Últimos valores para exponer por la API
-String latestRFIDUID = "--";
-float lastDistance = 0.0;
+// Latencia del lazo de control (tiempo entre iteraciones de loop())
+LatencyHistogram loopStats;
+uint32_t lastLoopUs = 0;
 
-// Timestamps de entrada/salida por cajón ("--" si no hay registro)
-String lastEntryTime[SLOTS_COUNT];
-String lastExitTime[SLOTS_COUNT];
+// Watchdog del lazo: su registro vive en RTC y sobrevive al reinicio por software
+RTC_NOINIT_ATTR WatchdogRecord watchdogRecord;
+LoopWatchdog watchdog;
+esp_timer_handle_t watchdogTimer = nullptr;
 
-// Parámetros configurables (valores por defecto tomados de config.h)
-int SALIDA_DELAY_MS = EXIT_RAISE_MS;
-// Tiempo de espera dinámico para que el ultrasonico considere aparecer un auto (ms)
-int ULTRASONIC_TIMEOUT_MS_VAR = ULTRASONIC_TIMEOUT_MS;
+// Heap, pilas y nivel de memoria (decide qué rutas se dejan de servir)
+MemoryDiag memoryDiag;
+SoftTimer memoryTimer{MEMDIAG_SAMPLE_MS};
+// Tareas del sistema cuya pila se vigila además de loopTask
+static const char *const MONITORED_TASKS[] = {"esp_timer", "tiT", "wifi", "IDLE"};
 
 // Funciones de FS / API
 bool initFileSystem();
@@ -98,14 +63,28 @@ void setupWebServer();
 void handle_getStatus();
 void handle_getParams();
 void handle_setParams();
+void handle_getHistory();
+void handle_getLoopStats();
+void handle_getDiag();
+void handle_getMemory();
+void handle_getRfid();
+void handle_getEvents();
+void setupLanes();
+void startWatchdog();
+void sampleMemory();
+bool shedRoute(RouteClass route);
 void loadParamsFromFS();
 void saveParamsToFS();
 
 void setup()
 {
 	Serial.begin(SERIAL_BAUD);
-	setupSensors();
-	setupActuators();
+	// Antes que nada: rescatar las migas de pan del arranque anterior
+	watchdog.begin(watchdogRecord, millis());
+	controller.setWatchdog(&watchdog);
+	// Distinto en cada arranque: el collector detecta que la secuencia de eventos volvió a 1
+	controller.setBootId(esp_random());
+	setupLanes();
 	// Inicializar I2C explícitamente con pines definidos en config.h
 	Wire.begin(I2C_SDA_PIN, I2C_SCL_PIN);
 	// Inicializar pantalla SSD1306
@@ -117,8 +96,8 @@ void setup()
 	}
 	display.clearDisplay();
 	display.display();
-	// Mostrar estado inicial con contador de espacios disponibles
-	displayAvailableSlots();
+	// Posicionar plumas, configurar pines y mostrar contador de espacios
+	controller.begin();
 
 	// Inicializar WiFi en modo STA (Station)
 	Serial.println("Conectando a WiFi...");
@@ -167,6 +146,10 @@ void setup()
 	{
 		Serial.println("Warning: Could not initialize LittleFS");
 	}
+	else
+	{
+		loadParamsFromFS();
+	}
 
 	// Inicializar servidor web
 	setupWebServer();
@@ -174,388 +157,128 @@ void setup()
 	Serial.print("Web server iniciado en http://");
 	Serial.println(WiFi.localIP());
 
-	// Inicializar timestamps por cajón
-	for (int i = 0; i < SLOTS_COUNT; i++)
-	{
-		lastEntryTime[i] = "--";
-		lastExitTime[i] = "--";
-	}
-}
-
-// Devuelve fecha/hora formateada en ISO-like "YYYY-MM-DD HH:MM:SS" o "--" si no hay hora
-String getFormattedTime()
-{
-	time_t now = time(nullptr);
-	struct tm timeinfo;
-	if (!localtime_r(&now, &timeinfo))
-	{
-		return String("--");
-	}
-	char buf[32];
-	strftime(buf, sizeof(buf), "%Y-%m-%d %H:%M:%S", &timeinfo);
-	return String(buf);
+	// Recién ahora: WiFi y NTP bloquean a propósito durante el arranque
+	startWatchdog();
+	sampleMemory();
 }
 
 void loop()
 {
-	server.handleClient();
-	updateBarrierLogic();
-	updateDisplayLogic();
-	checkRFID();
-	checkUltrasonicSensor();
-	checkParkingSlots();
-}
-
-void setupSensors()
-{
-	SPI.begin();
-	rfid.PCD_Init();
-	pinMode(SENSOR_ULTRASONIC_TRIG, OUTPUT);
-	pinMode(SENSOR_ULTRASONIC_ECHO, INPUT);
-	pinMode(SWITCH_SLOT1, INPUT_PULLUP);
-	pinMode(SWITCH_SLOT2, INPUT_PULLUP);
-}
-
-void setupActuators()
-{
-	barrierServoEntry.attach(SERVO_ENTRY_PIN);
-	barrierServoExit.attach(SERVO_EXIT_PIN);
-	barrierServoEntry.write(SERVO_ANGLE_DOWN);
-	// Si el servo de salida está invertido mecánicamente, escribir el ángulo invertido
-	barrierServoExit.write( (SERVO_EXIT_INVERT) ? (180 - SERVO_ANGLE_DOWN) : (SERVO_ANGLE_DOWN) );
-	entranceBarrierRaised = false;
-	exitBarrierRaised = false;
-	pinMode(LED_RED_SLOT1, OUTPUT);
-	pinMode(LED_RED_SLOT2, OUTPUT);
-}
-
-void checkRFID()
-{
-	if (!rfidTimer.update())
-		return;
-	if (!rfid.PICC_IsNewCardPresent() || !rfid.PICC_ReadCardSerial())
-		return;
-	String cardUID = getCardUID();
-	latestRFIDUID = cardUID;
-	if (isCardAuthorized(cardUID))
-		handleAuthorizedUser();
-	else
-		handleUnauthorizedUser();
-	rfid.PICC_HaltA();
-	rfid.PCD_StopCrypto1();
-}
+	// Incluye el tiempo de atender HTTP: mide cuánto retrasa la carga al control
+	uint32_t nowUs = micros();
+	if (lastLoopUs)
+		loopStats.record(nowUs - lastLoopUs);
+	lastLoopUs = nowUs;
 
-String getCardUID()
-{
-	String uid = "";
-	for (int i = 0; i < rfid.uid.size; i++)
-	{
-		if (rfid.uid.uidByte[i] < 0x10)
-			uid += "0";
-		uid += String(rfid.uid.uidByte[i], HEX);
-		if (i < rfid.uid.size - 1)
-			uid += ":";
-	}
-	uid.toUpperCase();
-	return uid;
-}
+	if (memoryTimer.update(millis()))
+		sampleMemory();
 
-bool isCardAuthorized(String cardUID)
-{
-	for (int i = 0; i < AUTHORIZED_CARDS_COUNT; i++)
-	{
-		if (cardUID.equalsIgnoreCase(String(AUTHORIZED_CARDS[i])))
-			return true;
-	}
-	return false;
-}
-
-void handleAuthorizedUser()
-{
-	// Verificar disponibilidad antes de conceder acceso
-	if (availableSlots <= 0)
-	{
-		displayMessage(MSG_FULL_1, MSG_FULL_2);
-		displayMessageTimer.start();
-		deniedMessageActive = true;
-		return;
-	}
-
-	// Crear una reserva temporal: decremento real ocurrirá cuando el usuario
-	// confirme ocupación presionando el switch del cajón.
-	pendingEntries++;
-	Serial.println("[RFID] Tarjeta válida. Levantando pluma y esperando auto...");
-	displayMessage(MSG_WELCOME_1, MSG_WELCOME_2);
-	raiseEntranceBarrier();
-	// Iniciar la lógica de espera: o detecta auto, o timeout en 10s
-	entranceBarrierPhase = 1; // Esperar a que el auto pase
-	carDetectedRecently = false;
-	carCurrentlyDetected = false;
-	ultrasonicNoCarTimer.setdelay(ULTRASONIC_TIMEOUT_MS_VAR);
-	ultrasonicNoCarTimer.start();
-	successMessageTimer.start();
-	authorizedMessageActive = true;
+	watchdog.enter(STAGE_HTTP, millis());
+	server.handleClient();
+	controller.update();
+	watchdog.enter(STAGE_IDLE, millis());
 }
 
-void handleUnauthorizedUser()
-{
-	displayMessage(MSG_DENIED_1, MSG_DENIED_2);
-	displayMessageTimer.start();
-	deniedMessageActive = true;
-}
+// ------------------------- Carriles -------------------------
 
-void checkUltrasonicSensor()
+void setupLanes()
 {
-	if (!entranceBarrierRaised || entranceBarrierPhase == 0)
-		return;
-	if (!ultrasonicTimer.update())
-		return;
-
-	// Generar pulso en TRIG
-	digitalWrite(SENSOR_ULTRASONIC_TRIG, LOW);
-	delayMicroseconds(ULTRASONIC_TRIG_PREP_US);
-	digitalWrite(SENSOR_ULTRASONIC_TRIG, HIGH);
-	delayMicroseconds(ULTRASONIC_TRIG_PULSE_US);
-	digitalWrite(SENSOR_ULTRASONIC_TRIG, LOW);
-
-	// Leer duración del pulso en ECHO
-	unsigned long duration = pulseIn(SENSOR_ULTRASONIC_ECHO, HIGH, ULTRASONIC_PULSE_TIMEOUT_US);
-
-	// Convertir duración a distancia (cm)
-	float distance = duration * ULTRASONIC_FACTOR / 2;
-
-	Serial.printf("[US] Duration: %lu us | Distancia: %f cm\n", duration, distance);
-
-	lastDistance = distance;
-
-	// Validar que la distancia sea razonable (entre 2cm y 400cm)
-	if (distance < 2 || distance > 400)
-	{
-		Serial.printf("[US] Lectura inválida: %f cm\n", distance);
-		return;
-	}
-
-	bool carDetected = (distance < ULTRASONIC_THRESHOLD); // < 30cm = bloqueado = hay auto
-
-	Serial.printf("[US] Distancia: %f cm | Detectado: %d | Fase: %d\n", distance, carDetected, entranceBarrierPhase);
-
-	if (entranceBarrierPhase == 1)
+	// Todos los lectores comparten el bus SPI; cada uno tiene su SS
+	SPI.begin();
+	for (int i = 0; i < LANE_COUNT; i++)
 	{
-		// Esperando a que el auto pase
-		if (carDetected)
+		const LaneConfig &lane = LANES[i];
+		halServos[i].begin(lane.servoPin, lane.ledcChannel);
+		HalPulseCapture *detector = nullptr;
+		HalRfidReader *reader = nullptr;
+		if (lane.trigPin != LANE_NO_PIN)
 		{
-			// Auto detectado (bloqueando sensor)
-			if (!carCurrentlyDetected)
-			{
-				carCurrentlyDetected = true;
-				carDetectedRecently = true;
-				Serial.println("[US] Auto detectado: sensor bloqueado");
-			}
-			// Resetear timeout mientras el auto esté siendo detectado
-			ultrasonicNoCarTimer.setdelay(ULTRASONIC_TIMEOUT_MS_VAR);
-			ultrasonicNoCarTimer.start();
+			halDetectors[i].begin(lane.trigPin, lane.echoPin);
+			detector = &halDetectors[i];
 		}
-		if (!carDetected && carCurrentlyDetected && carDetectedRecently)
+		if (lane.rfidSsPin != LANE_NO_PIN)
 		{
-			// Auto pasó: se detectó antes (estaba bloqueado), ahora se fue (desbloqueado)
-			carCurrentlyDetected = false;
-			entranceBarrierPhase = 3; // Bajar después de 1s
-			lowerBarrierWaitTimer.start();
-			Serial.println("[US] Auto pasó: sensor desbloqueado. Bajando pluma...");
+			halReaders[i].begin(lane.rfidSsPin, RFID_RST_PIN);
+			reader = &halReaders[i];
 		}
+		controller.addLane(lane, halServos[i], detector, reader);
 	}
 }
 
-void raiseEntranceBarrier()
-{
-		barrierServoEntry.write(SERVO_ANGLE_UP);
-	entranceBarrierRaised = true;
-	servoTimer.start();
-}
-void lowerEntranceBarrier()
-{
-		barrierServoEntry.write(SERVO_ANGLE_DOWN);
-	entranceBarrierRaised = false;
-	servoTimer.start();
-}
+// ------------------------- Watchdog -------------------------
 
-void raiseExitBarrier()
+// Corre en la tarea de esp_timer: sigue activo aunque loop() esté colgado
+static void onWatchdogPoll(void *)
 {
-		barrierServoExit.write( (SERVO_EXIT_INVERT) ? (180 - SERVO_ANGLE_UP) : (SERVO_ANGLE_UP) );
-	exitBarrierRaised = true;
-	servoTimer.start();
-}
-void lowerExitBarrier()
-{
-		barrierServoExit.write( (SERVO_EXIT_INVERT) ? (180 - SERVO_ANGLE_DOWN) : (SERVO_ANGLE_DOWN) );
-	exitBarrierRaised = false;
-	servoTimer.start();
+	uint32_t now = (uint32_t)(esp_timer_get_time() / 1000);
+	if (!watchdog.poll(now))
+		return;
+	watchdog.markRestart(millis());
+	Serial.printf("[WDT] Lazo colgado en '%s'. Reiniciando...\n", LoopWatchdog::stageName(watchdogRecord.stage));
+	Serial.flush();
+	esp_restart();
 }
 
-void checkParkingSlots()
+void startWatchdog()
 {
-	int slots[SLOTS_COUNT] = {SWITCH_SLOT1, SWITCH_SLOT2};
-	for (int i = 0; i < SLOTS_COUNT; i++)
-	{
-		bool pressed = (digitalRead(slots[i]) == LOW);
-		// Entrada al cajón (usuario acaba de estacionar)
-		if (pressed && !slotOccupied[i])
-		{
-			slotOccupied[i] = true;
-			updateLED(i, true);
-			// Registrar timestamp de entrada
-			lastEntryTime[i] = getFormattedTime();
-			// Si hay reservas pendientes, asociar una a esta ocupación.
-			if (pendingEntries > 0)
-			{
-				pendingEntries--;
-				if (availableSlots > 0)
-					availableSlots--;
-			}
-			else
-			{
-				// Ocupación manual sin reserva previa
-				if (availableSlots > 0)
-					availableSlots--;
-			}
-			if (availableSlots < 0)
-				availableSlots = 0;
-			Serial.printf("Cajon %d - OCUPADO. Disponibles: %d\n", i + 1, availableSlots);
-			// Actualizar contador en pantalla si no hay mensajes temporales activos
-			if (!deniedMessageActive && !authorizedMessageActive && !timeoutMessageActive)
-			{
-				displayAvailableSlots();
-			}
-		}
-		// Salida del cajón (usuario marcó que desocupó)
-		else if (!pressed && slotOccupied[i])
-		{
-			slotOccupied[i] = false;
-			updateLED(i, false);
-			// Registrar timestamp de salida
-			lastExitTime[i] = getFormattedTime();
-			availableSlots++;
-			Serial.printf("Cajon %d - DISPONIBLE. Disponibles: %d\n", i + 1, availableSlots);
-			// Actualizar contador en pantalla si no hay mensajes temporales activos
-			if (!deniedMessageActive && !authorizedMessageActive && !timeoutMessageActive)
-			{
-				displayAvailableSlots();
-			}
-			// Iniciar secuencia de salida que levanta la pluma y luego la baja
-			exitSequenceActive = true;
-			exitPhase = 1;
-			exitRaiseTimer.start();
-		}
-	}
+	esp_timer_create_args_t args = {};
+	args.callback = &onWatchdogPoll;
+	args.name = "loop_wdt";
+	esp_timer_create(&args, &watchdogTimer);
+	esp_timer_start_periodic(watchdogTimer, WATCHDOG_POLL_MS * 1000ULL);
 }
 
-void updateLED(int slot, bool occupied)
-{
-	int leds[SLOTS_COUNT] = {LED_RED_SLOT1, LED_RED_SLOT2};
-	digitalWrite(leds[slot], occupied ? HIGH : LOW);
-}
+// ------------------------- Memoria -------------------------
 
-void displayMessage(String line1, String line2)
+void sampleMemory()
 {
-	display.clearDisplay();
-	display.setTextSize(1);
-	display.setTextColor(SSD1306_WHITE);
-	display.setCursor(0, 0);
-	display.print(line1);
-	if (line2.length())
+	MemorySample sample;
+	sample.freeHeap = ESP.getFreeHeap();
+	sample.minFreeHeap = ESP.getMinFreeHeap();
+	sample.largestBlock = heap_caps_get_largest_free_block(MALLOC_CAP_8BIT);
+	memoryDiag.record(sample);
+	// En ESP-IDF la marca de agua de la pila ya está en bytes
+	memoryDiag.recordStack("loopTask", uxTaskGetStackHighWaterMark(NULL));
+	for (const char *name : MONITORED_TASKS)
 	{
-		display.setCursor(0, 12);
-		display.print(line2);
+		TaskHandle_t task = xTaskGetHandle(name);
+		if (task)
+			memoryDiag.recordStack(name, uxTaskGetStackHighWaterMark(task));
 	}
-	display.display();
-}
-void clearDisplay()
-{
-	display.clearDisplay();
-	display.display();
 }
 
-// Extensión: manejar la secuencia de salida (timers) además del timeout
-void updateBarrierLogic()
+// Con poca memoria se contesta 503 en vez de atender la ruta
+bool shedRoute(RouteClass route)
 {
-	// Lógica para pluma de entrada
-	if (entranceBarrierRaised && entranceBarrierPhase > 0)
-	{
-		// Fase 1: esperando a que pase el auto (timeout 10s - esperar más tiempo a detección real)
-		if (entranceBarrierPhase == 1 && ultrasonicNoCarTimer.update())
-		{
-			// Timeout: no se detectó auto en 10s, bajar pluma
-			entranceBarrierPhase = 3;
-			lowerBarrierWaitTimer.start();
-			Serial.println("[TIMEOUT] No se detectó auto. Bajando pluma...");
-			// Mostrar mensaje distinto cuando nunca se detectó el auto
-			displayMessage(MSG_TIMEOUT_1, MSG_TIMEOUT_2);
-			displayMessageTimer.start();
-			timeoutMessageActive = true;
-		}
-		// Fase 3: esperar 1s antes de bajar
-		if (entranceBarrierPhase == 3 && lowerBarrierWaitTimer.update())
-		{
-			lowerEntranceBarrier();
-			entranceBarrierPhase = 0;
-			// Mostrar mensaje de paso y activar el flag para que se restaure luego
-			displayMessage(MSG_PASS_1, MSG_PASS_2);
-			authorizedMessageActive = true;
-			successMessageTimer.start();
-		}
-	}
-
-	// Secuencia de salida (usa la pluma de salida)
-	if (exitSequenceActive)
-	{
-		if (exitPhase == 1 && exitRaiseTimer.update())
-		{
-			raiseExitBarrier();
-			// ahora esperamos para bajar
-			exitPhase = 2;
-			// iniciar temporizador dinámico usando SALIDA_DELAY_MS
-			exitLowerStartMillis = millis();
-			exitLowerWaiting = true;
-		}
-		else if (exitPhase == 2 && exitLowerWaiting && (millis() - exitLowerStartMillis >= (unsigned long)SALIDA_DELAY_MS))
-		{
-			lowerExitBarrier();
-			exitSequenceActive = false;
-			exitPhase = 0;
-			exitLowerWaiting = false;
-		}
-	}
+	if (memoryDiag.allows(route))
+		return false;
+	server.send(503, "application/json", "{\"error\":\"low memory\"}");
+	return true;
 }
-void updateDisplayLogic()
+
+static const char *resetReasonText()
 {
-	if (deniedMessageActive && displayMessageTimer.update())
-	{
-		deniedMessageActive = false;
-		// Restaurar pantalla por defecto con contador
-		displayAvailableSlots();
-	}
-	if (authorizedMessageActive && successMessageTimer.update())
+	switch (esp_reset_reason())
 	{
-		authorizedMessageActive = false;
-		// Restaurar pantalla por defecto con contador
-		displayAvailableSlots();
+	case ESP_RST_POWERON:
+		return "poweron";
+	case ESP_RST_SW:
+		return "software";
+	case ESP_RST_PANIC:
+		return "panic";
+	case ESP_RST_INT_WDT:
+		return "int_wdt";
+	case ESP_RST_TASK_WDT:
+		return "task_wdt";
+	case ESP_RST_WDT:
+		return "wdt";
+	case ESP_RST_BROWNOUT:
+		return "brownout";
+	case ESP_RST_DEEPSLEEP:
+		return "deepsleep";
+	default:
+		return "other";
 	}
-	if (timeoutMessageActive && displayMessageTimer.update())
-	{
-		timeoutMessageActive = false;
-		// Restaurar pantalla por defecto con contador
-		displayAvailableSlots();
-	}
-}
-
-// Muestra en el OLED la cantidad de espacios disponibles cuando no hay mensajes
-void displayAvailableSlots()
-{
-	String line2 = String("Disp: ") + String(availableSlots);
-	// Asegurar que la línea tiene máximo 16 caracteres
-	if (line2.length() > 16)
-		line2 = line2.substring(0, 16);
-	displayMessage(MSG_READY_1, line2);
 }
 
 // ------------------------- LittleFS y WebServer -------------------------
@@ -589,6 +312,8 @@ void setupWebServer()
 	// Servir página principal desde LittleFS
 	server.on("/", HTTP_GET, []()
 			  {
+		if (shedRoute(ROUTE_DASHBOARD))
+			return;
 		if (LittleFS.exists("/index.html"))
 		{
 			File file = LittleFS.open("/index.html", "r");
@@ -604,6 +329,8 @@ void setupWebServer()
 	// Servir CSS
 	server.on("/style.css", HTTP_GET, []()
 			  {
+		if (shedRoute(ROUTE_DASHBOARD))
+			return;
 		if (LittleFS.exists("/style.css"))
 		{
 			File file = LittleFS.open("/style.css", "r");
@@ -619,6 +346,8 @@ void setupWebServer()
 	// Servir JavaScript
 	server.on("/script.js", HTTP_GET, []()
 			  {
+		if (shedRoute(ROUTE_DASHBOARD))
+			return;
 		if (LittleFS.exists("/script.js"))
 		{
 			File file = LittleFS.open("/script.js", "r");
@@ -635,66 +364,171 @@ void setupWebServer()
 	server.on("/api/getStatus", HTTP_GET, handle_getStatus);
 	server.on("/api/getParams", HTTP_GET, handle_getParams);
 	server.on("/api/setParams", HTTP_POST, handle_setParams);
+	server.on("/api/history", HTTP_GET, handle_getHistory);
+	server.on("/api/loopStats", HTTP_GET, handle_getLoopStats);
+	server.on("/api/diag", HTTP_GET, handle_getDiag);
+	server.on("/api/memory", HTTP_GET, handle_getMemory);
+	server.on("/api/rfid", HTTP_GET, handle_getRfid);
+	server.on("/api/events", HTTP_GET, handle_getEvents);
 }
 
 void handle_getStatus()
 {
-	DynamicJsonDocument doc(512);
-	doc["rfidUID"] = latestRFIDUID;
-	doc["distancia"] = lastDistance;
-	doc["plumaEntrada"] = entranceBarrierRaised;
-	doc["plumaSalida"] = exitBarrierRaised;
-	for (int i = 0; i < SLOTS_COUNT; i++)
-	{
-		String key = String("cajon") + String(i + 1);
-		doc[key] = slotOccupied[i];
-	}
-	// Agregar timestamps de entrada/salida
-	for (int i = 0; i < SLOTS_COUNT; i++)
-	{
-		String ekey = String("entryTime") + String(i + 1);
-		String xkey = String("exitTime") + String(i + 1);
-		doc[ekey] = lastEntryTime[i];
-		doc[xkey] = lastExitTime[i];
-	}
-	String out;
-	serializeJson(doc, out);
-	server.send(200, "application/json", out);
+	char out[API_RESPONSE_MAX];
+	int code = api_getStatus(controller, out, sizeof(out));
+	server.send(code, "application/json", out);
 }
 
 void handle_getParams()
 {
-	DynamicJsonDocument doc(256);
-	doc["SALIDA_DELAY_MS"] = SALIDA_DELAY_MS;
-	doc["ULTRASONIC_TIMEOUT_MS"] = ULTRASONIC_TIMEOUT_MS_VAR;
-	String out;
-	serializeJson(doc, out);
-	server.send(200, "application/json", out);
+	char out[API_RESPONSE_MAX];
+	int code = api_getParams(controller, out, sizeof(out));
+	server.send(code, "application/json", out);
 }
 
 void handle_setParams()
 {
-	if (!server.hasArg("plain"))
+	char out[API_RESPONSE_MAX];
+	int code = api_setParams(controller, server.hasArg("plain") ? server.arg("plain").c_str() : "", out, sizeof(out));
+	if (code == 200)
+		saveParamsToFS();
+	server.send(code, "application/json", out);
+}
+
+// GET /api/loopStats[?reset=1]
+void handle_getLoopStats()
+{
+	if (shedRoute(ROUTE_HEAVY))
+		return;
+	char out[API_RESPONSE_MAX];
+	int code = api_getLoopStats(loopStats, server.arg("reset") == "1", out, sizeof(out));
+	server.send(code, "application/json", out);
+}
+
+// GET /api/diag
+void handle_getDiag()
+{
+	char out[API_DIAG_RESPONSE_MAX];
+	int code = api_getDiag(watchdog, millis(), resetReasonText(), out, sizeof(out));
+	server.send(code, "application/json", out);
+}
+
+// GET /api/memory
+void handle_getMemory()
+{
+	char out[API_DIAG_RESPONSE_MAX];
+	int code = api_getMemory(memoryDiag, out, sizeof(out));
+	server.send(code, "application/json", out);
+}
+
+// GET /api/rfid
+void handle_getRfid()
+{
+	char out[API_RESPONSE_MAX];
+	int code = api_getRfid(controller, millis(), out, sizeof(out));
+	server.send(code, "application/json", out);
+}
+
+// GET /api/events?since=<seq>: lo usa el collector para medir latencias
+void handle_getEvents()
+{
+	char out[API_RESPONSE_MAX];
+	uint32_t since = server.hasArg("since") ? strtoul(server.arg("since").c_str(), nullptr, 10) : 0;
+	int code = api_getEvents(controller, since, millis(), out, sizeof(out));
+	server.send(code, "application/json", out);
+}
+
+// GET /api/history?res=raw|1s|1m&since=<millis>&fmt=json|bin&lane=<i>
+// lane = índice del carril (por defecto el primero de entrada).
+// Se transmite en chunks para no armar toda la respuesta en RAM.
+// JSON raw: [[t,mm],...]   JSON buckets: [[t,min,max,mean,count],...]
+// Binario (little-endian): raw = u32 t, u16 mm; buckets = u32 t, u16 min, u16 max, u16 mean, u16 count
+void handle_getHistory()
+{
+	if (shedRoute(ROUTE_HEAVY))
+		return;
+	HistoryResolution res;
+	if (!DistanceHistory::parseResolution(server.arg("res").c_str(), res))
 	{
-		server.send(400, "application/json", "{\"error\":\"no body\"}");
+		server.send(400, "application/json", "{\"error\":\"invalid res\"}");
 		return;
 	}
-	String body = server.arg("plain");
-	DynamicJsonDocument doc(256);
-	DeserializationError err = deserializeJson(doc, body);
-	if (err)
+	int lane = server.hasArg("lane") ? atoi(server.arg("lane").c_str()) : controller.entryLaneIndex();
+	if (lane < 0 || lane >= controller.laneCount() || !controller.lane(lane).hasDetector())
 	{
-		server.send(400, "application/json", "{\"error\":\"invalid json\"}");
+		server.send(400, "application/json", "{\"error\":\"invalid lane\"}");
 		return;
 	}
-	if (doc.containsKey("SALIDA_DELAY_MS"))
-		SALIDA_DELAY_MS = doc["SALIDA_DELAY_MS"];
-	if (doc.containsKey("ULTRASONIC_TIMEOUT_MS"))
-		ULTRASONIC_TIMEOUT_MS_VAR = doc["ULTRASONIC_TIMEOUT_MS"];
-	if (doc.containsKey("ULTRASONIC_TIMEOUT_MS"))
-		ultrasonicNoCarTimer.setdelay(ULTRASONIC_TIMEOUT_MS_VAR);
-	saveParamsToFS();
-	server.send(200, "application/json", "{\"ok\":true}");
+	uint32_t since = server.hasArg("since") ? strtoul(server.arg("since").c_str(), nullptr, 10) : 0;
+	bool binary = (server.arg("fmt") == "bin");
+
+	size_t first = controller.history().firstIndexSince(res, since);
+	size_t total = controller.history().count(res);
+
+	server.setContentLength(CONTENT_LENGTH_UNKNOWN);
+	if (binary)
+	{
+		server.sendHeader("X-Record-Size", (res == HISTORY_RAW) ? "6" : "12");
+		server.send(200, "application/octet-stream", "");
+	}
+	else
+	{
+		server.send(200, "application/json", "");
+		char head[80];
+		snprintf(head, sizeof(head), "{\"res\":\"%s\",\"lane\":%d,\"now\":%lu,\"samples\":[",
+				 server.arg("res").length() ? server.arg("res").c_str() : "raw", lane, (unsigned long)millis());
+		server.sendContent(head);
+	}
+
+	// Buffer para un chunk de registros (el peor caso es JSON de buckets)
+	char chunk[HISTORY_CHUNK_RECORDS * 48];
+	size_t len = 0;
+	int inChunk = 0;
+	bool any = false;
+	for (size_t i = first; i < total; i++)
+	{
+		DistanceBucket b = controller.history().bucketAt(res, i);
+		if (b.lane != lane)
+			continue;
+		if (binary)
+		{
+			memcpy(chunk + len, &b.tMs, 4);
+			len += 4;
+			if (res == HISTORY_RAW)
+			{
+				memcpy(chunk + len, &b.minMm, 2);
+				len += 2;
+			}
+			else
+			{
+				uint16_t fields[4] = {b.minMm, b.maxMm, b.meanMm(), b.count};
+				memcpy(chunk + len, fields, sizeof(fields));
+				len += sizeof(fields);
+			}
+		}
+		else
+		{
+			const char *sep = any ? "," : "";
+			if (res == HISTORY_RAW)
+				len += snprintf(chunk + len, sizeof(chunk) - len, "%s[%lu,%u]", sep, (unsigned long)b.tMs, b.minMm);
+			else
+				len += snprintf(chunk + len, sizeof(chunk) - len, "%s[%lu,%u,%u,%u,%u]", sep, (unsigned long)b.tMs,
+								b.minMm, b.maxMm, b.meanMm(), b.count);
+		}
+		any = true;
+		if (++inChunk == HISTORY_CHUNK_RECORDS)
+		{
+			server.sendContent(chunk, len);
+			len = 0;
+			inChunk = 0;
+		}
+	}
+	if (len)
+		server.sendContent(chunk, len);
+	if (!binary)
+		server.sendContent("]}");
+	// Chunk vacío: fin de la respuesta
+	server.sendContent("");
 }
 
 void loadParamsFromFS()
@@ -720,36 +554,51 @@ void loadParamsFromFS()
 		Serial.println("Failed to open config file");
 		return;
 	}
-	size_t size = f.size();
-	std::unique_ptr<char[]> buf(new char[size + 1]);
-	f.readBytes(buf.get(), size);
-	buf[size] = '\0';
-	f.close();
+	// Un archivo corrupto o gigante no debe poder agotar el heap
+	if (f.size() > CONFIG_FILE_MAX)
+	{
+		Serial.printf("Config file too large (%u bytes), using defaults\n", (unsigned)f.size());
+		f.close();
+		return;
+	}
+	// Parsear directo desde el archivo, sin copia intermedia en el heap
 	DynamicJsonDocument doc(256);
-	DeserializationError err = deserializeJson(doc, buf.get());
+	DeserializationError err = deserializeJson(doc, f);
+	f.close();
 	if (err)
 	{
 		Serial.println("Failed to parse config JSON");
 		return;
 	}
+	api_recordJsonUsage(JSON_DOC_CONFIG_FILE, doc.memoryUsage(), doc.capacity());
 	if (doc.containsKey("SALIDA_DELAY_MS"))
-		SALIDA_DELAY_MS = doc["SALIDA_DELAY_MS"];
+		controller.salidaDelayMs = doc["SALIDA_DELAY_MS"];
 	if (doc.containsKey("ULTRASONIC_TIMEOUT_MS"))
-		ULTRASONIC_TIMEOUT_MS_VAR = doc["ULTRASONIC_TIMEOUT_MS"];
-	ultrasonicNoCarTimer.setdelay(ULTRASONIC_TIMEOUT_MS_VAR);
+		controller.ultrasonicTimeoutMs = doc["ULTRASONIC_TIMEOUT_MS"];
+	if (doc.containsKey("AUTO_TUNE"))
+		controller.autoTune = doc["AUTO_TUNE"];
+	controller.applyParams();
 	Serial.println("Config loaded from FS");
 }
 
 void saveParamsToFS()
 {
+	// La escritura en flash puede tardar: se atribuye a su propia etapa
+	uint32_t startMs = millis();
+	uint8_t prevStage = watchdog.enter(STAGE_FS, startMs);
 	DynamicJsonDocument doc(256);
-	doc["SALIDA_DELAY_MS"] = SALIDA_DELAY_MS;
-	doc["ULTRASONIC_TIMEOUT_MS"] = ULTRASONIC_TIMEOUT_MS_VAR;
+	doc["SALIDA_DELAY_MS"] = controller.salidaDelayMs;
+	doc["ULTRASONIC_TIMEOUT_MS"] = controller.ultrasonicTimeoutMs;
+	doc["AUTO_TUNE"] = controller.autoTune;
+	api_recordJsonUsage(JSON_DOC_CONFIG_FILE, doc.memoryUsage(), doc.capacity());
 	String out;
 	serializeJson(doc, out);
 	File f = LittleFS.open("/config.json", "w");
-	if (!f)
-		return;
-	f.print(out);
-	f.close();
+	if (f)
+	{
+		f.print(out);
+		f.close();
+	}
+	watchdog.note(CRUMB_FS, 0, millis() - startMs, millis());
+	watchdog.enter(prevStage, millis());
 }
@@ -0,0 +1,75 @@
+#include "memory_diag.h"
+
+#include <string.h>
+
+MemoryLevel MemoryDiag::levelFor(uint32_t freeHeap, uint32_t block, uint32_t margin) const
+{
+	if (freeHeap < MEMDIAG_CRITICAL_HEAP + margin || block < MEMDIAG_CRITICAL_BLOCK + margin)
+		return MEM_CRITICAL;
+	if (freeHeap < MEMDIAG_LOW_HEAP + margin || block < MEMDIAG_LOW_BLOCK + margin)
+		return MEM_LOW;
+	return MEM_NORMAL;
+}
+
+void MemoryDiag::record(const MemorySample &s)
+{
+	sample = s;
+	MemoryLevel worse = levelFor(s.freeHeap, s.largestBlock, 0);
+	if (worse >= current)
+	{
+		current = worse;
+		return;
+	}
+	// Mejorar solo con margen, para no oscilar en el umbral
+	MemoryLevel better = levelFor(s.freeHeap, s.largestBlock, MEMDIAG_HYSTERESIS);
+	if (better < current)
+		current = better;
+}
+
+void MemoryDiag::recordStack(const char *task, uint32_t freeBytes)
+{
+	for (uint8_t i = 0; i < tasks; i++)
+	{
+		if (strcmp(stacks[i].name, task) == 0)
+		{
+			stacks[i].freeBytes = freeBytes;
+			return;
+		}
+	}
+	if (tasks < MEMDIAG_MAX_TASKS)
+		stacks[tasks++] = {task, freeBytes};
+}
+
+uint8_t MemoryDiag::fragmentationPct() const
+{
+	if (sample.freeHeap == 0 || sample.largestBlock >= sample.freeHeap)
+		return 0;
+	return (uint8_t)(100 - (uint64_t)sample.largestBlock * 100 / sample.freeHeap);
+}
+
+const char *MemoryDiag::levelName(MemoryLevel level)
+{
+	switch (level)
+	{
+	case MEM_LOW:
+		return "low";
+	case MEM_CRITICAL:
+		return "critical";
+	default:
+		return "normal";
+	}
+}
+
+bool MemoryDiag::allows(RouteClass route)
+{
+	bool ok;
+	if (route == ROUTE_DASHBOARD)
+		ok = (current == MEM_NORMAL);
+	else if (route == ROUTE_HEAVY)
+		ok = (current != MEM_CRITICAL);
+	else
+		ok = true;
+	if (!ok)
+		shed++;
+	return ok;
+}
@@ -0,0 +1,123 @@
+#include "filter_replay.h"
+
+#include <stdio.h>
+#include <stdint.h>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "config.h"
+#include "ultrasonic_filter.h"
+
+struct ReplaySample
+{
+	uint32_t tMs;
+	uint16_t mm;
+	bool truth;
+};
+
+struct DetectorStats
+{
+	const char *name;
+	bool state = false;
+	bool detectedThisPassage = false;
+	uint32_t truthRiseMs = 0;
+	int detected = 0;
+	int missed = 0;
+	int falseTriggers = 0;
+	uint64_t latencySumMs = 0;
+	uint32_t latencyMaxMs = 0;
+
+	// Llamar en cada muestra con el nuevo estado del detector
+	void step(uint32_t tMs, bool truth, bool truthRise, bool truthFall, bool newState)
+	{
+		if (truthRise)
+		{
+			truthRiseMs = tMs;
+			detectedThisPassage = false;
+		}
+		if (newState && !state)
+		{
+			if (truth && !detectedThisPassage)
+			{
+				uint32_t latency = tMs - truthRiseMs;
+				detected++;
+				latencySumMs += latency;
+				if (latency > latencyMaxMs)
+					latencyMaxMs = latency;
+				detectedThisPassage = true;
+			}
+			else if (!truth)
+				falseTriggers++;
+		}
+		if (truthFall && !detectedThisPassage)
+			missed++;
+		state = newState;
+	}
+
+	void print() const
+	{
+		printf("%-8s detectadas %d | perdidas %d | falsos disparos %d | latencia prom %lu ms, máx %lu ms\n", name,
+			   detected, missed, falseTriggers, (unsigned long)(detected ? latencySumMs / detected : 0),
+			   (unsigned long)latencyMaxMs);
+	}
+};
+
+static bool loadReplay(const char *path, std::vector<ReplaySample> &out)
+{
+	std::ifstream file(path);
+	if (!file)
+		return false;
+	std::string text;
+	while (std::getline(file, text))
+	{
+		size_t hash = text.find('#');
+		if (hash != std::string::npos)
+			text.erase(hash);
+		std::istringstream in(text);
+		unsigned long t, mm;
+		int truth;
+		if (in >> t >> mm >> truth)
+			out.push_back({(uint32_t)t, (uint16_t)mm, truth != 0});
+	}
+	return true;
+}
+
+int runFilterReplay(const char *path)
+{
+	std::vector<ReplaySample> samples;
+	if (!loadReplay(path, samples))
+	{
+		fprintf(stderr, "no se pudo abrir %s\n", path);
+		return 2;
+	}
+
+	UltrasonicFilter filter;
+	DetectorStats raw{"crudo"};
+	DetectorStats filtered{"filtro"};
+	int passages = 0;
+	bool lastTruth = false;
+	for (const ReplaySample &s : samples)
+	{
+		bool rise = s.truth && !lastTruth;
+		bool fall = !s.truth && lastTruth;
+		if (rise)
+			passages++;
+		lastTruth = s.truth;
+
+		// Umbral crudo (comportamiento anterior): una lectura decide
+		bool rawValid = (s.mm >= ULTRASONIC_MIN_MM && s.mm <= ULTRASONIC_MAX_MM);
+		bool rawState = rawValid ? (s.mm < ULTRASONIC_THRESHOLD * 10) : raw.state;
+		raw.step(s.tMs, s.truth, rise, fall, rawState);
+
+		uint32_t echoUs = (uint32_t)s.mm * ULTRASONIC_MM_DEN / ULTRASONIC_MM_NUM;
+		filter.addEcho(echoUs);
+		filtered.step(s.tMs, s.truth, rise, fall, filter.present());
+	}
+
+	printf("%s: %zu lecturas, %d pasadas reales\n", path, samples.size(), passages);
+	raw.print();
+	filtered.print();
+	return (filtered.falseTriggers || filtered.missed) ? 1 : 0;
+}
@@ -0,0 +1,17 @@
+// =====================================================================
+// REPRODUCCIÓN DE TRAZAS DEL ULTRASÓNICO CONTRA EL FILTRO
+// =====================================================================
+//
+// Archivo de texto con una lectura por línea: "<t_ms> <mm> <verdad>",
+// donde verdad = 1 si realmente había un vehículo. Los datos de
+// /api/history?res=raw sirven de base (agregando la columna de verdad).
+// Compara el umbral crudo de antes contra UltrasonicFilter y reporta
+// falsos disparos, pasadas no detectadas y latencia de detección.
+
+#ifndef SIM_FILTER_REPLAY_H
+#define SIM_FILTER_REPLAY_H
+
+// Devuelve 0 si el filtro no tuvo falsos disparos ni pasadas perdidas
+int runFilterReplay(const char *path);
+
+#endif // SIM_FILTER_REPLAY_H
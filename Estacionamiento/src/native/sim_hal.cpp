@@ -0,0 +1,163 @@
+#include "sim_hal.h"
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#include "config.h"
+
+bool simVerbose = false;
+
+void halLogf(const char *fmt, ...)
+{
+	if (!simVerbose)
+		return;
+	va_list args;
+	va_start(args, fmt);
+	vfprintf(stderr, fmt, args);
+	va_end(args);
+}
+
+void SimEventLog::record(uint32_t tMs, const char *kind, const std::string &detail)
+{
+	items.push_back({tMs, kind, detail});
+	if (limit && items.size() > limit)
+		items.pop_front();
+	if (strcmp(kind, "display") == 0)
+		displays[detail.substr(0, detail.find(" | "))]++;
+	if (echo)
+		printf("%10lu %-12s %s\n", (unsigned long)tMs, kind, detail.c_str());
+}
+
+uint32_t SimEventLog::displayCount(const char *line1) const
+{
+	auto it = displays.find(line1);
+	return it == displays.end() ? 0 : it->second;
+}
+
+bool SimClock::formatWallTime(char *buf, size_t len)
+{
+	time_t now = (time_t)(bootEpoch + nowMs / 1000);
+	struct tm timeinfo;
+	if (!gmtime_r(&now, &timeinfo))
+		return false;
+	strftime(buf, len, "%Y-%m-%d %H:%M:%S", &timeinfo);
+	return true;
+}
+
+SimGpio::SimGpio(SimClock &clock, SimEventLog &log) : clock(clock), log(log)
+{
+	memset(levels, HAL_LOW, sizeof(levels));
+}
+
+void SimGpio::pinMode(uint8_t pin, uint8_t mode)
+{
+	// Con pull-up la entrada queda en HIGH mientras nadie la lleve a LOW
+	if (mode == HAL_INPUT_PULLUP)
+		levels[pin & 63] = HAL_HIGH;
+}
+
+void SimGpio::digitalWrite(uint8_t pin, uint8_t level)
+{
+	levels[pin & 63] = level;
+	char detail[16];
+	snprintf(detail, sizeof(detail), "%u=%u", pin, level);
+	log.record(clock.millis(), "led", detail);
+}
+
+uint32_t SimUltrasonic::measureEchoUs()
+{
+	// LCG determinista: la misma semilla reproduce el mismo ruido
+	seed = seed * 1103515245u + 12345u;
+	samples++;
+	if (stallMs)
+	{
+		clock.advance(stallMs);
+		stallMs = 0;
+	}
+	uint16_t mm = distanceMm;
+	if (spikePermille && ((seed >> 16) % 1000) < spikePermille)
+		mm = spikeMm;
+	return (uint32_t)mm * ULTRASONIC_MM_DEN / ULTRASONIC_MM_NUM;
+}
+
+uint8_t SimRfidReader::poll(char *uid, size_t len)
+{
+	if (halting)
+	{
+		halting = false;
+		return RFID_NONE;
+	}
+	if (pending.empty())
+		return RFID_NONE;
+	if (stepMs)
+		clock.advance(stepMs);
+	if (progress < steps)
+	{
+		progress++;
+		return RFID_PENDING;
+	}
+	progress = 0;
+	snprintf(uid, len, "%s", pending.front().c_str());
+	pending.pop_front();
+	halting = true;
+	return RFID_CARD;
+}
+
+void SimServo::setAngle(int newAngle)
+{
+	motion.setPosition(newAngle);
+	angle = newAngle;
+	arrived = false;
+	lastVelocity = 0;
+	lastTickMs = clock.millis();
+	log.record(clock.millis(), name.c_str(), std::to_string(newAngle));
+}
+
+void SimServo::moveTo(int newAngle)
+{
+	motion.moveTo(newAngle, clock.millis());
+	log.record(clock.millis(), name.c_str(), std::to_string(newAngle));
+	tick();
+}
+
+void SimServo::tick()
+{
+	uint32_t now = clock.millis();
+	angle = (motion.update(now) + 50) / 100;
+	// Un salto de velocidad en el mismo ms cuenta como si hubiera pasado 1 ms
+	int32_t velocity = motion.velocityCentiDegS();
+	uint32_t dv = (uint32_t)(velocity > lastVelocity ? velocity - lastVelocity : lastVelocity - velocity);
+	uint32_t dt = now - lastTickMs ? now - lastTickMs : 1;
+	if (dv * 10 / dt > maxAccelDegS2)
+		maxAccelDegS2 = dv * 10 / dt;
+	lastVelocity = velocity;
+	lastTickMs = now;
+	if (motion.takeArrived())
+	{
+		arrived = true;
+		log.record(clock.millis(), finName.c_str(), std::to_string(motion.targetAngle()));
+	}
+}
+
+bool SimServo::takeArrived()
+{
+	bool value = arrived;
+	arrived = false;
+	return value;
+}
+
+void SimDisplay::showMessage(const char *l1, const char *l2)
+{
+	line1 = l1;
+	line2 = l2 ? l2 : "";
+	log.record(clock.millis(), "display", line1 + " | " + line2);
+}
+
+void SimDisplay::clear()
+{
+	line1.clear();
+	line2.clear();
+	log.record(clock.millis(), "display", "");
+}
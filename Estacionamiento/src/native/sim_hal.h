@@ -0,0 +1,159 @@
+// =====================================================================
+// HAL SIMULADA PARA [env:native]
+// =====================================================================
+//
+// Reloj virtual (avanza solo cuando el simulador lo indica), pines en
+// memoria, sensor ultrasónico con distancia programable y ruido
+// determinista, lector RFID con cola de tarjetas, y servos/pantalla que
+// registran cada escritura como evento para poder verificarla.
+
+#ifndef SIM_HAL_H
+#define SIM_HAL_H
+
+#include <stdint.h>
+#include <map>
+#include <string>
+#include <vector>
+#include <deque>
+
+#include "hal.h"
+#include "servo_motion.h"
+
+// Evento de salida registrado por el simulador
+struct SimEvent
+{
+	uint32_t tMs;
+	std::string kind;   // "servo_<carril>", "servo_<carril>_fin", "led", "display"
+	std::string detail; // ángulo, pin=nivel o texto mostrado
+};
+
+class SimEventLog
+{
+public:
+	void record(uint32_t tMs, const char *kind, const std::string &detail);
+	const std::deque<SimEvent> &events() const { return items; }
+	// Veces que la pantalla mostró un mensaje con esa primera línea (aunque
+	// el evento ya se haya descartado por el límite)
+	uint32_t displayCount(const char *line1) const;
+	bool echo = false; // imprimir cada evento al registrarlo
+	// Eventos guardados como máximo (0 = todos); --serve corre sin fin
+	size_t limit = 0;
+
+private:
+	std::deque<SimEvent> items;
+	std::map<std::string, uint32_t> displays;
+};
+
+class SimClock : public HalClock
+{
+public:
+	uint32_t millis() override { return nowMs; }
+	uint32_t micros() override { return nowMs * 1000; }
+	bool formatWallTime(char *buf, size_t len) override;
+	void advance(uint32_t ms) { nowMs += ms; }
+
+	uint32_t nowMs = 0;
+	// Época de arranque del simulador (segundos UNIX, UTC)
+	int64_t bootEpoch = 1735689600; // 2025-01-01 00:00:00
+};
+
+class SimGpio : public HalGpio
+{
+public:
+	SimGpio(SimClock &clock, SimEventLog &log);
+	void pinMode(uint8_t pin, uint8_t mode) override;
+	void digitalWrite(uint8_t pin, uint8_t level) override;
+	int digitalRead(uint8_t pin) override { return levels[pin & 63]; }
+	// Entrada externa (switch de cajón)
+	void setInput(uint8_t pin, uint8_t level) { levels[pin & 63] = level; }
+
+private:
+	SimClock &clock;
+	SimEventLog &log;
+	uint8_t levels[64];
+};
+
+class SimUltrasonic : public HalPulseCapture
+{
+public:
+	explicit SimUltrasonic(SimClock &clock) : clock(clock) {}
+	uint32_t measureEchoUs() override;
+
+	// La próxima medición bloquea este tiempo (como un pulseIn colgado)
+	uint32_t stallMs = 0;
+
+	uint16_t distanceMm = 2500;
+	// Probabilidad (por mil) de un eco espurio y su distancia
+	uint16_t spikePermille = 0;
+	uint16_t spikeMm = 100;
+	uint32_t seed = 1;
+	uint32_t samples = 0;
+
+private:
+	SimClock &clock;
+};
+
+// Lector con cola de tarjetas. Una transacción con tarjeta son `steps`
+// pasos RFID_PENDING más el paso que entrega el UID; cada paso bloquea
+// `stepMs` (avanza el reloj), como un MFRC522 lento en el bus
+class SimRfidReader : public HalRfidReader
+{
+public:
+	explicit SimRfidReader(SimClock &clock) : clock(clock) {}
+	uint8_t poll(char *uid, size_t len) override;
+	void present(const std::string &uid) { pending.push_back(uid); }
+
+	uint8_t steps = 0;
+	uint32_t stepMs = 0;
+
+private:
+	SimClock &clock;
+	std::deque<std::string> pending;
+	uint8_t progress = 0;
+	bool halting = false;
+};
+
+// Servo con el mismo perfil que el firmware; registra cada orden como
+// evento "<name>" y cada llegada al destino como "<name>_fin"
+class SimServo : public HalServo
+{
+public:
+	SimServo(SimClock &clock, SimEventLog &log, const std::string &name) : clock(clock), log(log), name(name), finName(name + "_fin") {}
+	void setAngle(int angle) override;
+	void moveTo(int angle) override;
+	bool takeArrived() override;
+	// Avanzar la trayectoria (equivale al timer del ESP32)
+	void tick();
+	int angle = -1;
+	// Mayor cambio de velocidad observado entre dos ticks (grados/s^2)
+	uint32_t maxAccelDegS2 = 0;
+
+private:
+	SimClock &clock;
+	SimEventLog &log;
+	std::string name;
+	std::string finName;
+	ServoMotion motion;
+	bool arrived = false;
+	int32_t lastVelocity = 0;
+	uint32_t lastTickMs = 0;
+};
+
+class SimDisplay : public HalDisplay
+{
+public:
+	SimDisplay(SimClock &clock, SimEventLog &log) : clock(clock), log(log) {}
+	void showMessage(const char *line1, const char *line2) override;
+	void clear() override;
+	std::string line1;
+	std::string line2;
+
+private:
+	SimClock &clock;
+	SimEventLog &log;
+};
+
+// Log de la lógica (halLogf) hacia stderr solo con --verbose
+extern bool simVerbose;
+
+#endif // SIM_HAL_H
@@ -0,0 +1,163 @@
+#include "sim_http.h"
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <sys/select.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+// Límite de cabeceras + cuerpo de una petición
+#define SIM_HTTP_MAX_REQUEST 8192
+// Tiempo máximo esperando los datos de un cliente ya aceptado
+#define SIM_HTTP_READ_TIMEOUT_MS 200
+
+SimHttpServer::~SimHttpServer()
+{
+	if (listenFd >= 0)
+		close(listenFd);
+}
+
+bool SimHttpServer::begin(uint16_t port)
+{
+	listenFd = socket(AF_INET, SOCK_STREAM, 0);
+	if (listenFd < 0)
+		return false;
+	int yes = 1;
+	setsockopt(listenFd, SOL_SOCKET, SO_REUSEADDR, &yes, sizeof(yes));
+	sockaddr_in addr = {};
+	addr.sin_family = AF_INET;
+	addr.sin_port = htons(port);
+	addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+	if (bind(listenFd, (sockaddr *)&addr, sizeof(addr)) < 0 || listen(listenFd, 16) < 0)
+	{
+		close(listenFd);
+		listenFd = -1;
+		return false;
+	}
+	return true;
+}
+
+std::string SimHttpServer::queryArg(const SimHttpRequest &req, const char *name)
+{
+	std::string key = std::string(name) + "=";
+	size_t pos = 0;
+	while (pos < req.query.size())
+	{
+		size_t end = req.query.find('&', pos);
+		if (end == std::string::npos)
+			end = req.query.size();
+		if (req.query.compare(pos, key.size(), key) == 0)
+			return req.query.substr(pos + key.size(), end - pos - key.size());
+		pos = end + 1;
+	}
+	return "";
+}
+
+bool SimHttpServer::readRequest(int fd, SimHttpRequest &req)
+{
+	timeval tv = {0, SIM_HTTP_READ_TIMEOUT_MS * 1000};
+	setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+
+	std::string data;
+	size_t headerEnd = std::string::npos;
+	char buf[1024];
+	while (headerEnd == std::string::npos)
+	{
+		ssize_t n = recv(fd, buf, sizeof(buf), 0);
+		if (n <= 0 || data.size() + n > SIM_HTTP_MAX_REQUEST)
+			return false;
+		data.append(buf, n);
+		headerEnd = data.find("\r\n\r\n");
+	}
+
+	// Línea de petición: METHOD /path?query HTTP/1.1
+	size_t sp1 = data.find(' ');
+	size_t sp2 = data.find(' ', sp1 + 1);
+	if (sp1 == std::string::npos || sp2 == std::string::npos)
+		return false;
+	req.method = data.substr(0, sp1);
+	std::string target = data.substr(sp1 + 1, sp2 - sp1 - 1);
+	size_t q = target.find('?');
+	req.path = target.substr(0, q);
+	req.query = (q == std::string::npos) ? "" : target.substr(q + 1);
+
+	size_t contentLength = 0;
+	size_t lineStart = data.find("\r\n") + 2;
+	while (lineStart < headerEnd)
+	{
+		size_t lineEnd = data.find("\r\n", lineStart);
+		std::string line = data.substr(lineStart, lineEnd - lineStart);
+		if (strncasecmp(line.c_str(), "Content-Length:", 15) == 0)
+			contentLength = strtoul(line.c_str() + 15, nullptr, 10);
+		lineStart = lineEnd + 2;
+	}
+	if (contentLength > SIM_HTTP_MAX_REQUEST)
+		return false;
+
+	req.body = data.substr(headerEnd + 4);
+	while (req.body.size() < contentLength)
+	{
+		ssize_t n = recv(fd, buf, sizeof(buf), 0);
+		if (n <= 0)
+			return false;
+		req.body.append(buf, n);
+	}
+	req.body.resize(contentLength);
+	return true;
+}
+
+static const char *statusText(int code)
+{
+	switch (code)
+	{
+	case 200:
+		return "OK";
+	case 400:
+		return "Bad Request";
+	case 404:
+		return "Not Found";
+	case 503:
+		return "Service Unavailable";
+	}
+	return "Error";
+}
+
+void SimHttpServer::handleClient(int waitMs)
+{
+	if (listenFd < 0)
+		return;
+	fd_set fds;
+	FD_ZERO(&fds);
+	FD_SET(listenFd, &fds);
+	timeval tv = {0, waitMs * 1000};
+	if (select(listenFd + 1, &fds, nullptr, nullptr, &tv) <= 0)
+		return;
+	int fd = accept(listenFd, nullptr, nullptr);
+	if (fd < 0)
+		return;
+
+	SimHttpRequest req;
+	SimHttpResponse res;
+	if (readRequest(fd, req))
+	{
+		handler(req, res);
+		requests++;
+	}
+	else
+	{
+		res.code = 400;
+		res.body = "{\"error\":\"bad request\"}";
+	}
+
+	char head[256];
+	int n = snprintf(head, sizeof(head),
+					 "HTTP/1.1 %d %s\r\nContent-Type: %s\r\nContent-Length: %zu\r\nConnection: close\r\n\r\n",
+					 res.code, statusText(res.code), res.contentType.c_str(), res.body.size());
+	send(fd, head, n, MSG_NOSIGNAL);
+	send(fd, res.body.data(), res.body.size(), MSG_NOSIGNAL);
+	close(fd);
+}
@@ -0,0 +1,57 @@
+// =====================================================================
+// SERVIDOR HTTP DE LOOPBACK PARA EL SIMULADOR
+// =====================================================================
+//
+// Imita al WebServer del ESP32: un solo hilo, una conexión atendida por
+// cada handleClient() y "Connection: close". Se llama desde el mismo lazo
+// que ParkingController::update(), así la carga HTTP retrasa el control
+// igual que en la placa.
+
+#ifndef SIM_HTTP_H
+#define SIM_HTTP_H
+
+#include <stdint.h>
+#include <functional>
+#include <string>
+
+struct SimHttpRequest
+{
+	std::string method;
+	std::string path;  // sin query
+	std::string query; // texto después de '?'
+	std::string body;
+};
+
+struct SimHttpResponse
+{
+	int code = 404;
+	std::string contentType = "application/json";
+	std::string body = "{\"error\":\"not found\"}";
+};
+
+class SimHttpServer
+{
+public:
+	typedef std::function<void(const SimHttpRequest &, SimHttpResponse &)> Handler;
+
+	explicit SimHttpServer(Handler handler) : handler(handler) {}
+	~SimHttpServer();
+
+	// Escuchar en 127.0.0.1:<port>
+	bool begin(uint16_t port);
+	// Atender como máximo una conexión; espera hasta waitMs si no hay ninguna
+	void handleClient(int waitMs);
+	uint32_t served() const { return requests; }
+
+	// Valor de un parámetro de query ("" si no está)
+	static std::string queryArg(const SimHttpRequest &req, const char *name);
+
+private:
+	bool readRequest(int fd, SimHttpRequest &req);
+
+	Handler handler;
+	int listenFd = -1;
+	uint32_t requests = 0;
+};
+
+#endif // SIM_HTTP_H
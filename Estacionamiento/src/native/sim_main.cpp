@@ -0,0 +1,678 @@
+// =====================================================================
+// SIMULADOR NATIVO - ejecuta ParkingController en Linux
+// =====================================================================
+//
+// Uso (tras `pio run -e native`):
+//   .pio/build/native/program --trace sim/traces/entrada_salida.trace
+//   .pio/build/native/program --synthetic-day 300 --seed 7
+//   .pio/build/native/program --filter-replay sim/traces/ultrasonico_ruidoso.txt
+//   .pio/build/native/program --serve 8080 --traffic-rate 120 --duration 60
+//
+// Opciones: --step <ms> (paso del reloj virtual, 1 por defecto),
+// --events (imprimir eventos de salida), --verbose (log de la lógica),
+// --auto-tune (activar el auto-ajuste de tiempos, AUTO_TUNE).
+// Devuelve 1 si alguna verificación (expect/expect_max) falla.
+//
+// --serve corre en tiempo real y expone la API del firmware (api_routes)
+// en 127.0.0.1:<puerto> para el benchmark pc/bench_api.py. Como el reloj es
+// el real, un --synthetic-day reparte sus autos en horas; --traffic-rate
+// <autos/h> genera en cambio tráfico continuo mientras dure la corrida.
+
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <chrono>
+#include <deque>
+#include <string>
+#include <vector>
+
+#include "config.h"
+#include "parking_controller.h"
+#include "api_routes.h"
+#include "latency_histogram.h"
+#include "loop_watchdog.h"
+#include "memory_diag.h"
+#include "sim_hal.h"
+#include "sim_http.h"
+#include "trace.h"
+#include "filter_replay.h"
+
+class Simulation
+{
+public:
+	SimEventLog log;
+	SimClock clock;
+	SimGpio gpio{clock, log};
+	SimDisplay display{clock, log};
+	ParkingController controller{{clock, gpio, display}};
+	// Carriles: los de LANE_TABLE, o los que pida la orden "lanes" de la traza.
+	// Cada servo registra sus eventos como "servo_<carril>"
+	std::deque<LaneConfig> laneConfigs;
+	std::deque<std::string> laneNames;
+	std::deque<SimServo> servos;
+	std::deque<SimUltrasonic> detectors;
+	std::deque<SimRfidReader> readers;
+	// Dispositivos de cada carril (nullptr si el carril no lo tiene)
+	std::vector<SimUltrasonic *> laneDetector;
+	std::vector<SimRfidReader *> laneReader;
+	uint32_t seed = 1;
+	// Autos por hora generados durante --serve (0 = solo las órdenes dadas)
+	uint32_t trafficRate = 0;
+	// Mismo watchdog que el firmware; aquí el "RTC" es memoria común
+	WatchdogRecord watchdogRecord = {};
+	LoopWatchdog watchdog;
+	// Sin heap real: las muestras llegan con la orden "heap" de la traza
+	MemoryDiag memoryDiag;
+
+	int failures = 0;
+	int checks = 0;
+	int cards = 0;
+
+	void setupLanes(const std::vector<TraceCommand> &commands);
+	void run(const std::vector<TraceCommand> &commands, uint32_t stepMs);
+	bool serve(const std::vector<TraceCommand> &given, uint16_t port, uint32_t durationS);
+	void report(double wallSeconds);
+
+private:
+	bool apply(const TraceCommand &cmd);
+	void route(const SimHttpRequest &req, SimHttpResponse &res);
+	void expectValue(const TraceCommand &cmd);
+	void expectMax(const TraceCommand &cmd);
+	int stateValue(const std::string &key, bool &known);
+	void addLane(uint8_t kind, const std::string &name, bool invert, bool detector, bool reader);
+	void tickServos();
+	int laneArg(const TraceCommand &cmd, size_t index, bool wantReader);
+
+	std::vector<TraceCommand> deferred;
+	// Latencia del lazo de control en modo --serve (igual que loop() del firmware)
+	LatencyHistogram loopStats;
+};
+
+static const uint8_t SIM_SLOT_PINS[SLOTS_COUNT] = {SWITCH_SLOT1, SWITCH_SLOT2};
+static const LaneConfig SIM_LANE_TABLE[LANE_COUNT] = LANE_TABLE;
+
+void Simulation::addLane(uint8_t kind, const std::string &name, bool invert, bool detector, bool reader)
+{
+	laneNames.push_back(name);
+	laneConfigs.push_back({kind, laneNames.back().c_str(), LANE_NO_PIN, 0, invert, LANE_NO_PIN, LANE_NO_PIN, LANE_NO_PIN});
+	servos.emplace_back(clock, log, "servo_" + name);
+	SimUltrasonic *us = nullptr;
+	SimRfidReader *rd = nullptr;
+	if (detector)
+	{
+		detectors.emplace_back(clock);
+		us = &detectors.back();
+		us->seed = seed + (uint32_t)detectors.size() - 1;
+	}
+	if (reader)
+	{
+		readers.emplace_back(clock);
+		rd = &readers.back();
+	}
+	laneDetector.push_back(us);
+	laneReader.push_back(rd);
+	controller.addLane(laneConfigs.back(), servos.back(), us, rd);
+}
+
+// "lanes <entradas> <salidas> [lector_salida]" en la traza reemplaza
+// LANE_TABLE; los carriles se crean antes de arrancar, así que la orden se
+// busca primero
+void Simulation::setupLanes(const std::vector<TraceCommand> &commands)
+{
+	for (const TraceCommand &cmd : commands)
+	{
+		if (cmd.op != "lanes" || cmd.args.size() < 2)
+			continue;
+		int entries = atoi(cmd.args[0].c_str());
+		int exits = atoi(cmd.args[1].c_str());
+		bool exitReaders = cmd.args.size() > 2 && atoi(cmd.args[2].c_str());
+		for (int i = 0; i < entries; i++)
+			addLane(LANE_ENTRY, i ? "entry" + std::to_string(i + 1) : "entry", false, true, true);
+		for (int i = 0; i < exits; i++)
+			addLane(LANE_EXIT, i ? "exit" + std::to_string(i + 1) : "exit", SERVO_EXIT_INVERT, false, exitReaders);
+		return;
+	}
+	for (const LaneConfig &lane : SIM_LANE_TABLE)
+		addLane(lane.kind, lane.name, lane.invertServo, lane.trigPin != LANE_NO_PIN, lane.rfidSsPin != LANE_NO_PIN);
+}
+
+void Simulation::tickServos()
+{
+	for (SimServo &servo : servos)
+		servo.tick();
+}
+
+// Carril (1..N) del argumento opcional; sin él, el primero con lector o ultrasónico
+int Simulation::laneArg(const TraceCommand &cmd, size_t index, bool wantReader)
+{
+	if (cmd.args.size() > index)
+	{
+		int lane = atoi(cmd.args[index].c_str()) - 1;
+		if (lane < 0 || lane >= (int)servos.size() || (wantReader ? !laneReader[lane] : !laneDetector[lane]))
+			return -1;
+		return lane;
+	}
+	for (size_t i = 0; i < servos.size(); i++)
+	{
+		if (wantReader ? laneReader[i] != nullptr : laneDetector[i] != nullptr)
+			return (int)i;
+	}
+	return -1;
+}
+
+void Simulation::run(const std::vector<TraceCommand> &commands, uint32_t stepMs)
+{
+	setupLanes(commands);
+	watchdog.begin(watchdogRecord, clock.nowMs);
+	controller.setWatchdog(&watchdog);
+	controller.begin();
+	size_t next = 0;
+	uint32_t endMs = commands.empty() ? 0 : commands.back().tMs;
+	bool stop = false;
+	for (;;)
+	{
+		while (next < commands.size() && commands[next].tMs <= clock.nowMs)
+		{
+			if (!apply(commands[next++]))
+				stop = true;
+		}
+		if (stop || (next >= commands.size() && clock.nowMs >= endMs))
+			break;
+		tickServos();
+		controller.update();
+		watchdog.enter(STAGE_IDLE, clock.nowMs);
+
+		// En reposo las vueltas no cambian nada: saltar, sin salir de la
+		// grilla de --step, hasta la vuelta anterior a la próxima orden o al
+		// próximo trabajo del controlador (esa vuelta sí corre, como la
+		// última antes del fin). La última saltada habría entrado a idle un paso antes
+		uint32_t wake = controller.idleUntilMs(clock.nowMs);
+		uint32_t nextCmd = (next < commands.size()) ? commands[next].tMs : endMs;
+		if ((int32_t)(nextCmd - wake) < 0)
+			wake = nextCmd;
+		int32_t ahead = (int32_t)(wake - clock.nowMs);
+		uint32_t steps = (ahead > 0) ? (uint32_t)ahead / stepMs : 0;
+		if (steps > 2)
+		{
+			clock.advance((steps - 1) * stepMs);
+			watchdog.resume(clock.nowMs - stepMs);
+		}
+		else
+			clock.advance(stepMs);
+	}
+	for (const TraceCommand &cmd : deferred)
+		expectMax(cmd);
+}
+
+// Eventos de salida que conserva --serve (corre sin fin; el reporte usa contadores)
+static const size_t SERVE_LOG_MAX = 1000;
+
+static volatile sig_atomic_t stopRequested = 0;
+
+static void onSignal(int)
+{
+	stopRequested = 1;
+}
+
+void Simulation::route(const SimHttpRequest &req, SimHttpResponse &res)
+{
+	char out[API_RESPONSE_MAX];
+	if (req.method == "GET" && req.path == "/api/getStatus")
+		res.code = api_getStatus(controller, out, sizeof(out));
+	else if (req.method == "GET" && req.path == "/api/getParams")
+		res.code = api_getParams(controller, out, sizeof(out));
+	else if (req.method == "POST" && req.path == "/api/setParams")
+		res.code = api_setParams(controller, req.body.c_str(), out, sizeof(out));
+	else if (req.method == "GET" && req.path == "/api/loopStats" && !memoryDiag.allows(ROUTE_HEAVY))
+	{
+		res.code = 503;
+		res.body = "{\"error\":\"low memory\"}";
+		return;
+	}
+	else if (req.method == "GET" && req.path == "/api/loopStats")
+		res.code = api_getLoopStats(loopStats, SimHttpServer::queryArg(req, "reset") == "1", out, sizeof(out));
+	else if (req.method == "GET" && req.path == "/api/diag")
+	{
+		char diag[API_DIAG_RESPONSE_MAX];
+		res.code = api_getDiag(watchdog, clock.nowMs, "sim", diag, sizeof(diag));
+		res.body = diag;
+		return;
+	}
+	else if (req.method == "GET" && req.path == "/api/rfid")
+		res.code = api_getRfid(controller, clock.nowMs, out, sizeof(out));
+	else if (req.method == "GET" && req.path == "/api/events")
+		res.code = api_getEvents(controller, strtoul(SimHttpServer::queryArg(req, "since").c_str(), nullptr, 10),
+								 clock.nowMs, out, sizeof(out));
+	else if (req.method == "GET" && req.path == "/api/memory")
+	{
+		char mem[API_DIAG_RESPONSE_MAX];
+		res.code = api_getMemory(memoryDiag, mem, sizeof(mem));
+		res.body = mem;
+		return;
+	}
+	else
+		return;
+	res.body = out;
+}
+
+bool Simulation::serve(const std::vector<TraceCommand> &given, uint16_t port, uint32_t durationS)
+{
+	// Tráfico generado un minuto por delante del reloj
+	const uint32_t TRAFFIC_AHEAD_MS = 60000;
+	std::vector<TraceCommand> commands = given;
+	TrafficSource traffic(trafficRate, seed);
+	uint32_t trafficUntil = 0;
+
+	SimHttpServer http([this](const SimHttpRequest &req, SimHttpResponse &res)
+					   { route(req, res); });
+	if (!http.begin(port))
+	{
+		fprintf(stderr, "no se pudo escuchar en 127.0.0.1:%u\n", port);
+		return false;
+	}
+	signal(SIGINT, onSignal);
+	signal(SIGTERM, onSignal);
+	printf("API en http://127.0.0.1:%u (Ctrl+C para terminar)\n", port);
+	fflush(stdout);
+
+	log.limit = SERVE_LOG_MAX;
+	// Cada --serve es un arranque nuevo para el collector
+	controller.setBootId((uint32_t)std::chrono::system_clock::now().time_since_epoch().count());
+	setupLanes(commands);
+	watchdog.begin(watchdogRecord, 0);
+	controller.setWatchdog(&watchdog);
+	controller.begin();
+	auto start = std::chrono::steady_clock::now();
+	auto lastLoop = start;
+	size_t next = 0;
+	// Las órdenes rfid/stall adelantan el reloj simulado: ese tiempo se suma
+	// como desfase para que el reloj nunca retroceda (los SoftTimer no lo toleran)
+	uint32_t offsetMs = 0;
+	while (!stopRequested)
+	{
+		auto now = std::chrono::steady_clock::now();
+		uint32_t wallMs = (uint32_t)std::chrono::duration_cast<std::chrono::milliseconds>(now - start).count();
+		if (clock.nowMs > wallMs + offsetMs)
+			offsetMs = clock.nowMs - wallMs;
+		clock.nowMs = wallMs + offsetMs;
+		if (durationS && clock.nowMs >= durationS * 1000UL)
+			break;
+		loopStats.record((uint32_t)std::chrono::duration_cast<std::chrono::microseconds>(now - lastLoop).count());
+		lastLoop = now;
+
+		if (trafficRate && clock.nowMs + TRAFFIC_AHEAD_MS > trafficUntil)
+		{
+			trafficUntil = clock.nowMs + 2 * TRAFFIC_AHEAD_MS;
+			traffic.fill(trafficUntil, commands, next);
+		}
+		while (next < commands.size() && commands[next].tMs <= clock.nowMs)
+		{
+			if (!apply(commands[next++]))
+				stopRequested = 1;
+		}
+		// Como en loop(): primero HTTP y después el control
+		watchdog.enter(STAGE_HTTP, clock.nowMs);
+		http.handleClient(1);
+		tickServos();
+		controller.update();
+		watchdog.enter(STAGE_IDLE, clock.nowMs);
+	}
+	printf("Peticiones atendidas: %lu\n", (unsigned long)http.served());
+	return true;
+}
+
+bool Simulation::apply(const TraceCommand &cmd)
+{
+	const std::vector<std::string> &a = cmd.args;
+	bool readerOp = (cmd.op == "card" || cmd.op == "rfid");
+	size_t laneIndex = (cmd.op == "rfid") ? 2 : 1;
+	if ((cmd.op == "card" || cmd.op == "dist" || cmd.op == "stall" || cmd.op == "rfid") &&
+		(a.size() == laneIndex || a.size() == laneIndex + 1))
+	{
+		int lane = laneArg(cmd, laneIndex, readerOp);
+		if (lane < 0)
+		{
+			fprintf(stderr, "línea %d: carril sin %s\n", cmd.line, readerOp ? "lector" : "ultrasónico");
+			failures++;
+			return false;
+		}
+		if (cmd.op == "rfid")
+		{
+			laneReader[lane]->steps = (uint8_t)atoi(a[0].c_str());
+			laneReader[lane]->stepMs = strtoul(a[1].c_str(), nullptr, 10);
+		}
+		else if (cmd.op == "card")
+		{
+			laneReader[lane]->present(a[0]);
+			cards++;
+		}
+		else if (cmd.op == "dist")
+			laneDetector[lane]->distanceMm = (uint16_t)atoi(a[0].c_str());
+		else
+			laneDetector[lane]->stallMs = strtoul(a[0].c_str(), nullptr, 10);
+	}
+	else if (cmd.op == "noise" && a.size() == 2)
+	{
+		for (SimUltrasonic &us : detectors)
+		{
+			us.spikePermille = (uint16_t)atoi(a[0].c_str());
+			us.spikeMm = (uint16_t)atoi(a[1].c_str());
+		}
+	}
+	else if (cmd.op == "lanes")
+	{
+		// Ya aplicada en setupLanes()
+	}
+	else if (cmd.op == "slot" && a.size() == 2)
+	{
+		int slot = atoi(a[0].c_str()) - 1;
+		if (slot < 0 || slot >= SLOTS_COUNT)
+		{
+			fprintf(stderr, "línea %d: cajón inválido %s\n", cmd.line, a[0].c_str());
+			return false;
+		}
+		// Switch con pull-up: ocupado = presionado = LOW
+		gpio.setInput(SIM_SLOT_PINS[slot], atoi(a[1].c_str()) ? HAL_LOW : HAL_HIGH);
+	}
+	else if (cmd.op == "heap" && a.size() == 2)
+	{
+		MemorySample sample;
+		sample.freeHeap = strtoul(a[0].c_str(), nullptr, 10);
+		sample.largestBlock = strtoul(a[1].c_str(), nullptr, 10);
+		uint32_t minFree = memoryDiag.last().minFreeHeap;
+		sample.minFreeHeap = (minFree && minFree < sample.freeHeap) ? minFree : sample.freeHeap;
+		memoryDiag.record(sample);
+	}
+	else if (cmd.op == "expect" && a.size() == 2)
+		expectValue(cmd);
+	else if (cmd.op == "expect_max" && a.size() == 2)
+		deferred.push_back(cmd);
+	else if (cmd.op == "end")
+		return false;
+	else
+	{
+		fprintf(stderr, "línea %d: orden desconocida '%s'\n", cmd.line, cmd.op.c_str());
+		failures++;
+		return false;
+	}
+	return true;
+}
+
+int Simulation::stateValue(const std::string &key, bool &known)
+{
+	known = true;
+	if (key == "entry")
+		return controller.isEntranceBarrierRaised();
+	if (key == "exit")
+		return controller.isExitBarrierRaised();
+	if (key == "available")
+		return controller.getAvailableSlots();
+	if (key == "reserved")
+		return controller.getReservedSlots();
+	if (key == "sessions")
+		return controller.openSessions();
+	if (key == "events")
+		return (int)controller.events().lastSeq();
+	if (key == "entry_phase")
+		return controller.getEntrancePhase();
+	if (key == "exit_phase")
+		return controller.getExitPhase();
+	if (key == "mem_level")
+		return memoryDiag.level();
+	if (key == "stalls")
+	{
+		uint32_t total = 0;
+		for (uint8_t i = 0; i < STAGE_COUNT; i++)
+			total += watchdogRecord.stalls[i];
+		return (int)total;
+	}
+	if (key.compare(0, 4, "lane") == 0)
+	{
+		char *rest = nullptr;
+		int lane = (int)strtol(key.c_str() + 4, &rest, 10) - 1;
+		if (lane >= 0 && lane < controller.laneCount())
+		{
+			if (!*rest)
+				return controller.lane(lane).isRaised();
+			if (strcmp(rest, "_phase") == 0)
+				return controller.lane(lane).phase();
+		}
+	}
+	if (key.compare(0, 4, "slot") == 0)
+	{
+		int slot = atoi(key.c_str() + 4) - 1;
+		if (slot >= 0 && slot < SLOTS_COUNT)
+			return controller.isSlotOccupied(slot);
+	}
+	known = false;
+	return 0;
+}
+
+void Simulation::expectValue(const TraceCommand &cmd)
+{
+	bool known;
+	int expected = atoi(cmd.args[1].c_str());
+	int actual = stateValue(cmd.args[0], known);
+	checks++;
+	if (!known || actual != expected)
+	{
+		failures++;
+		printf("FALLA t=%lu (línea %d): %s = %d, se esperaba %d\n", (unsigned long)cmd.tMs, cmd.line,
+			   cmd.args[0].c_str(), actual, expected);
+	}
+}
+
+// Ciclo completo: desde la orden de subir hasta que la pluma llega abajo
+// (evento "cerrada"); una reversión durante la bajada alarga el mismo ciclo.
+// Se verifica el primer carril de cada tipo.
+void Simulation::expectMax(const TraceCommand &cmd)
+{
+	const std::string &metric = cmd.args[0];
+	if (metric == "reader_wait_ms" || metric == "read_latency_ms")
+	{
+		// Peor caso entre todos los lectores
+		uint32_t maxMs = 0;
+		const RfidScheduler &sched = controller.readers();
+		for (int i = 0; i < sched.count(); i++)
+		{
+			uint32_t v = (metric == "reader_wait_ms") ? sched.stats(i).waitMaxMs : sched.stats(i).read.maxMs;
+			if (v > maxMs)
+				maxMs = v;
+		}
+		uint32_t limit = strtoul(cmd.args[1].c_str(), nullptr, 10);
+		checks++;
+		if (maxMs > limit)
+		{
+			failures++;
+			printf("FALLA (línea %d): %s máximo %lu ms > %lu ms\n", cmd.line, metric.c_str(),
+				   (unsigned long)maxMs, (unsigned long)limit);
+		}
+		return;
+	}
+	if (metric == "servo_accel_deg_s2")
+	{
+		// Peor cambio de velocidad entre ticks de todos los servos (reversas incluidas)
+		uint32_t maxAccel = 0;
+		for (const SimServo &servo : servos)
+		{
+			if (servo.maxAccelDegS2 > maxAccel)
+				maxAccel = servo.maxAccelDegS2;
+		}
+		uint32_t limit = strtoul(cmd.args[1].c_str(), nullptr, 10);
+		checks++;
+		if (maxAccel > limit)
+		{
+			failures++;
+			printf("FALLA (línea %d): %s máximo %lu > %lu\n", cmd.line, metric.c_str(), (unsigned long)maxAccel,
+				   (unsigned long)limit);
+		}
+		return;
+	}
+	int lane = -1;
+	for (int i = 0; i < controller.laneCount() && lane < 0; i++)
+	{
+		if ((metric == "entry_cycle_ms" && controller.lane(i).isEntry()) ||
+			(metric == "exit_cycle_ms" && !controller.lane(i).isEntry()))
+			lane = i;
+	}
+	if (lane < 0)
+	{
+		failures++;
+		printf("FALLA (línea %d): métrica desconocida %s\n", cmd.line, metric.c_str());
+		return;
+	}
+	uint32_t maxMs = controller.lane(lane).cycle().maxMs;
+	uint32_t limit = strtoul(cmd.args[1].c_str(), nullptr, 10);
+	checks++;
+	if (maxMs > limit)
+	{
+		failures++;
+		printf("FALLA (línea %d): %s máximo %lu ms > %lu ms\n", cmd.line, metric.c_str(),
+			   (unsigned long)maxMs, (unsigned long)limit);
+	}
+}
+
+void Simulation::report(double wallSeconds)
+{
+	int timeouts = (int)log.displayCount(MSG_TIMEOUT_1);
+	int full = (int)log.displayCount(MSG_FULL_1);
+
+	double simSeconds = clock.nowMs / 1000.0;
+	printf("Tiempo simulado: %.1f s en %.2f s reales (x%.0f)\n", simSeconds, wallSeconds,
+		   wallSeconds > 0 ? simSeconds / wallSeconds : 0.0);
+	unsigned long samples = 0;
+	for (const SimUltrasonic &us : detectors)
+		samples += us.samples;
+	printf("Tarjetas: %d | LLENO: %d | Timeouts ultrasónico: %d | Lecturas ultrasónico: %lu | Eventos: %lu\n", cards,
+		   full, timeouts, samples, (unsigned long)controller.events().lastSeq());
+	for (int i = 0; i < controller.laneCount(); i++)
+	{
+		const Gate &gate = controller.lane(i);
+		printf("Pluma %-7s %lu ciclos, prom %lu ms, máx %lu ms | %lu pasadas (%lu/h) | apertura prom %lu ms\n",
+			   gate.name(), (unsigned long)gate.cycle().count, (unsigned long)gate.cycle().meanMs(),
+			   (unsigned long)gate.cycle().maxMs, (unsigned long)gate.passes(), (unsigned long)gate.passesPerHour(),
+			   (unsigned long)gate.openLatency().meanMs());
+	}
+	const RfidScheduler &sched = controller.readers();
+	for (int i = 0; i < sched.count(); i++)
+	{
+		const RfidReaderStats &st = sched.stats(i);
+		printf("Lector %-6s %lu consultas (%lu/min), paso prom %lu us máx %lu us | espera máx %lu ms | %lu tarjetas, lectura prom %lu ms máx %lu ms\n",
+			   controller.lane(sched.lane(i)).name(), (unsigned long)st.polls,
+			   (unsigned long)sched.pollsPerMinute(i, clock.nowMs), (unsigned long)st.pollMeanUs(),
+			   (unsigned long)st.pollMaxUs, (unsigned long)st.waitMaxMs, (unsigned long)st.cards,
+			   (unsigned long)st.read.meanMs(), (unsigned long)st.read.maxMs);
+	}
+	const AutoTuner &tuner = controller.learned();
+	printf("Auto-ajuste %s: timeout ultrasónico %d ms (p%d %lu ms, %lu muestras, %lu sin auto) | delay salida %d ms (p%d %lu ms, %lu muestras)\n",
+		   controller.autoTune ? "activo" : "inactivo", controller.effectiveUltrasonicTimeoutMs(), AUTOTUNE_PERCENTILE,
+		   (unsigned long)tuner.approach.quantileMs(), (unsigned long)tuner.approach.samples(),
+		   (unsigned long)tuner.approach.censored(), controller.effectiveSalidaDelayMs(), AUTOTUNE_PERCENTILE, (unsigned long)tuner.passage.quantileMs(), (unsigned long)tuner.passage.samples());
+	printf("Bloqueos de etapa (>= %d ms):", WATCHDOG_STALL_MS);
+	bool anyStall = false;
+	for (uint8_t i = 0; i < STAGE_COUNT; i++)
+	{
+		if (!watchdogRecord.stalls[i])
+			continue;
+		printf(" %s %lu (máx %lu ms)", LoopWatchdog::stageName(i), (unsigned long)watchdogRecord.stalls[i],
+			   (unsigned long)watchdogRecord.longestStallMs[i]);
+		anyStall = true;
+	}
+	printf("%s\n", anyStall ? "" : " ninguno");
+	printf("Verificaciones: %d, fallas: %d\n", checks, failures);
+}
+
+static void usage()
+{
+	fprintf(stderr, "uso: program (--trace <archivo> | --synthetic-day <autos> | --filter-replay <archivo>)\n"
+					"               [--seed <n>] [--step <ms>] [--events] [--verbose] [--auto-tune]\n"
+					"               [--serve <puerto> [--duration <s>] [--traffic-rate <autos/h>]]\n");
+}
+
+int main(int argc, char **argv)
+{
+	const char *tracePath = nullptr;
+	const char *replayPath = nullptr;
+	int syntheticCars = -1;
+	uint32_t seed = 1;
+	uint32_t stepMs = 1;
+	bool printEvents = false;
+	int servePort = 0;
+	uint32_t durationS = 0;
+	uint32_t trafficRate = 0;
+	bool autoTune = false;
+
+	for (int i = 1; i < argc; i++)
+	{
+		bool hasValue = (i + 1 < argc);
+		if (strcmp(argv[i], "--trace") == 0 && hasValue)
+			tracePath = argv[++i];
+		else if (strcmp(argv[i], "--filter-replay") == 0 && hasValue)
+			replayPath = argv[++i];
+		else if (strcmp(argv[i], "--synthetic-day") == 0 && hasValue)
+			syntheticCars = atoi(argv[++i]);
+		else if (strcmp(argv[i], "--seed") == 0 && hasValue)
+			seed = strtoul(argv[++i], nullptr, 10);
+		else if (strcmp(argv[i], "--step") == 0 && hasValue)
+			stepMs = strtoul(argv[++i], nullptr, 10);
+		else if (strcmp(argv[i], "--serve") == 0 && hasValue)
+			servePort = atoi(argv[++i]);
+		else if (strcmp(argv[i], "--duration") == 0 && hasValue)
+			durationS = strtoul(argv[++i], nullptr, 10);
+		else if (strcmp(argv[i], "--traffic-rate") == 0 && hasValue)
+			trafficRate = strtoul(argv[++i], nullptr, 10);
+		else if (strcmp(argv[i], "--events") == 0)
+			printEvents = true;
+		else if (strcmp(argv[i], "--verbose") == 0)
+			simVerbose = true;
+		else if (strcmp(argv[i], "--auto-tune") == 0)
+			autoTune = true;
+		else
+		{
+			usage();
+			return 2;
+		}
+	}
+
+	if (replayPath)
+		return runFilterReplay(replayPath);
+
+	std::vector<TraceCommand> commands;
+	if (tracePath)
+	{
+		std::string error;
+		if (!loadTrace(tracePath, commands, error))
+		{
+			fprintf(stderr, "%s\n", error.c_str());
+			return 2;
+		}
+	}
+	else if (syntheticCars >= 0)
+		generateSyntheticDay(syntheticCars, seed, commands);
+	else if (!servePort)
+	{
+		usage();
+		return 2;
+	}
+	if (stepMs == 0)
+		stepMs = 1;
+
+	Simulation sim;
+	sim.log.echo = printEvents;
+	sim.seed = seed;
+	sim.trafficRate = trafficRate;
+	sim.controller.autoTune = autoTune;
+	if (servePort)
+	{
+		if (!sim.serve(commands, (uint16_t)servePort, durationS))
+			return 2;
+		sim.report(sim.clock.nowMs / 1000.0);
+		return sim.failures ? 1 : 0;
+	}
+	auto start = std::chrono::steady_clock::now();
+	sim.run(commands, stepMs);
+	std::chrono::duration<double> wall = std::chrono::steady_clock::now() - start;
+	sim.report(wall.count());
+	return sim.failures ? 1 : 0;
+}
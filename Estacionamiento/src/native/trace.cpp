@@ -0,0 +1,178 @@
+#include "trace.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+
+#include "config.h"
+
+bool loadTrace(const char *path, std::vector<TraceCommand> &out, std::string &error)
+{
+	std::ifstream file(path);
+	if (!file)
+	{
+		error = std::string("no se pudo abrir ") + path;
+		return false;
+	}
+	std::string text;
+	int lineNo = 0;
+	while (std::getline(file, text))
+	{
+		lineNo++;
+		size_t hash = text.find('#');
+		if (hash != std::string::npos)
+			text.erase(hash);
+		std::istringstream in(text);
+		std::string timeField;
+		if (!(in >> timeField))
+			continue;
+		TraceCommand cmd;
+		char *endp = nullptr;
+		cmd.tMs = strtoul(timeField.c_str(), &endp, 10);
+		if (*endp != '\0' || !(in >> cmd.op))
+		{
+			error = std::string(path) + ":" + std::to_string(lineNo) + ": línea inválida";
+			return false;
+		}
+		std::string arg;
+		while (in >> arg)
+			cmd.args.push_back(arg);
+		cmd.line = lineNo;
+		out.push_back(cmd);
+	}
+	// Orden estable: a igual tiempo se respeta el orden del archivo
+	std::stable_sort(out.begin(), out.end(), [](const TraceCommand &a, const TraceCommand &b)
+					 { return a.tMs < b.tMs; });
+	return true;
+}
+
+// xorshift32: suficiente para tráfico sintético reproducible
+static uint32_t nextRandom(uint32_t &state)
+{
+	state ^= state << 13;
+	state ^= state >> 17;
+	state ^= state << 5;
+	return state;
+}
+
+static uint32_t randomBetween(uint32_t &state, uint32_t lo, uint32_t hi)
+{
+	return lo + nextRandom(state) % (hi - lo + 1);
+}
+
+static void push(std::vector<TraceCommand> &out, uint32_t t, const char *op, std::vector<std::string> args)
+{
+	out.push_back({t, op, args, 0});
+}
+
+// Separación mínima entre autos para que un ciclo de pluma no pise al siguiente
+static const uint32_t MIN_GAP_MS = 20000;
+static const uint16_t FAR_MM = 2500;
+
+// Un auto que llega en t: tarjeta (5% no autorizadas), paso bajo la pluma,
+// estadía de stayMinMs a stayMaxMs en un cajón libre y salida.
+// Devuelve cuándo deja el cajón (0 si no entró)
+static uint32_t pushCar(uint32_t t, size_t index, uint32_t stayMinMs, uint32_t stayMaxMs, uint32_t &state,
+						uint32_t *slotFreeAt, std::vector<TraceCommand> &out)
+{
+	if (nextRandom(state) % 100 < 5)
+	{
+		push(out, t, "card", {"DE:AD:BE:EF"});
+		return 0;
+	}
+	push(out, t, "card", {AUTHORIZED_CARDS[index % AUTHORIZED_CARDS_COUNT]});
+
+	int slot = -1;
+	for (int i = 0; i < SLOTS_COUNT; i++)
+	{
+		if (slotFreeAt[i] <= t)
+		{
+			slot = i;
+			break;
+		}
+	}
+	// Lleno: el firmware muestra LLENO y el auto se va
+	if (slot < 0)
+		return 0;
+
+	// Paso bajo la pluma (el lector se consulta cada RFID_COOLDOWN ms,
+	// así que la pluma puede tardar hasta eso en subir)
+	uint32_t arrive = t + RFID_COOLDOWN + randomBetween(state, 300, 1500);
+	uint32_t clear = arrive + randomBetween(state, 1500, 4000);
+	push(out, arrive, "dist", {std::to_string(randomBetween(state, 120, 250))});
+	push(out, clear, "dist", {std::to_string(FAR_MM)});
+
+	// Estacionar y salir
+	uint32_t park = clear + randomBetween(state, 10000, 30000);
+	uint32_t leave = park + randomBetween(state, stayMinMs, stayMaxMs);
+	push(out, park, "slot", {std::to_string(slot + 1), "1"});
+	push(out, leave, "slot", {std::to_string(slot + 1), "0"});
+	slotFreeAt[slot] = leave + 1000;
+	return leave;
+}
+
+static void sortByTime(std::vector<TraceCommand> &out, size_t from)
+{
+	std::stable_sort(out.begin() + from, out.end(), [](const TraceCommand &a, const TraceCommand &b)
+					 { return a.tMs < b.tMs; });
+}
+
+void generateSyntheticDay(int cars, uint32_t seed, std::vector<TraceCommand> &out)
+{
+	const uint32_t DAY_MS = 24UL * 3600UL * 1000UL;
+
+	uint32_t state = seed ? seed : 1;
+	std::vector<uint32_t> arrivals;
+	for (int i = 0; i < cars; i++)
+		arrivals.push_back(randomBetween(state, 1000, DAY_MS - 4UL * 3600UL * 1000UL));
+	std::sort(arrivals.begin(), arrivals.end());
+
+	push(out, 0, "dist", {std::to_string(FAR_MM)});
+	// 2% de ecos espurios cercanos: el filtro no debe disparar con ellos
+	push(out, 0, "noise", {"20", "150"});
+
+	uint32_t slotFreeAt[SLOTS_COUNT] = {};
+	uint32_t gateFreeAt = 0;
+	uint32_t lastEvent = 0;
+	for (size_t c = 0; c < arrivals.size(); c++)
+	{
+		uint32_t t = std::max(arrivals[c], gateFreeAt);
+		gateFreeAt = t + MIN_GAP_MS;
+		// Estadía de 5 min a 3 h
+		uint32_t leave = pushCar(t, c, 5UL * 60000UL, 180UL * 60000UL, state, slotFreeAt, out);
+		lastEvent = std::max(lastEvent, leave);
+	}
+
+	uint32_t end = std::max(lastEvent, gateFreeAt) + 60000;
+	push(out, end, "expect", {"available", std::to_string(SLOTS_COUNT)});
+	push(out, end, "expect", {"entry", "0"});
+	push(out, end, "expect", {"exit", "0"});
+	push(out, end, "end", {});
+
+	sortByTime(out, 0);
+}
+
+// Un ciclo completo de pluma (lector, paso de hasta 5.5 s, espera y bajada)
+// cabe en 12 s: el tráfico continuo admite hasta 3600 s / 12 s = 300 autos/h
+static const uint32_t TRAFFIC_MIN_GAP_MS = 12000;
+
+TrafficSource::TrafficSource(uint32_t carsPerHour, uint32_t seed) : state(seed ? seed : 1)
+{
+	gapMs = carsPerHour ? 3600000UL / carsPerHour : 0;
+	if (gapMs < TRAFFIC_MIN_GAP_MS)
+		gapMs = TRAFFIC_MIN_GAP_MS;
+	nextArrival = 1000;
+}
+
+void TrafficSource::fill(uint32_t untilMs, std::vector<TraceCommand> &out, size_t from)
+{
+	while (nextArrival < untilMs)
+	{
+		// Estadías cortas para que los cajones se liberen durante la prueba
+		pushCar(nextArrival, cars++, 20000, 180000, state, slotFreeAt, out);
+		nextArrival += std::max(TRAFFIC_MIN_GAP_MS, randomBetween(state, gapMs / 2, gapMs + gapMs / 2));
+	}
+	sortByTime(out, from);
+}
@@ -0,0 +1,75 @@
+// =====================================================================
+// TRAZAS DE ENTRADA DEL SIMULADOR
+// =====================================================================
+//
+// Formato de texto, una orden por línea ('#' inicia comentario):
+//
+//   <t_ms> lanes <entradas> <salidas> [lector_salida]
+//                                 carriles a simular (en vez de LANE_TABLE);
+//                                 lector_salida = 1 pone lector en las salidas
+//   <t_ms> card <UID> [carril]    tarjeta presentada al lector
+//   <t_ms> rfid <pasos> <ms> [carril]   transacción lenta: pasos extra y ms por paso
+//   <t_ms> dist <mm> [carril]     distancia vista por el ultrasónico
+//   <t_ms> noise <permil> <mm>    ecos espurios: probabilidad por mil y distancia
+//   <t_ms> slot <n> <0|1>         switch del cajón n (1 = ocupado)
+//   <t_ms> stall <ms> [carril]    la próxima lectura del ultrasónico bloquea <ms>
+//   <t_ms> heap <libre> <bloque>  muestra de heap para el diagnóstico de memoria
+//   <t_ms> expect <clave> <valor> verificar estado en ese instante
+//   <t_ms> expect_max <métrica> <valor>   verificar al final de la corrida
+//   <t_ms> end                    fin de la simulación
+//
+// Los carriles se numeran desde 1 en orden de tabla (entradas primero con
+// "lanes"); sin número se usa el primero que tenga lector o ultrasónico.
+//
+// Claves de expect: entry, exit (pluma arriba 0/1), available, reserved, sessions,
+// events (último número de secuencia de /api/events),
+// slot<n>, entry_phase, exit_phase, lane<n> y lane<n>_phase (cualquier
+// carril), stalls (bloqueos de etapa vistos por el watchdog), mem_level
+// (0 normal, 1 bajo, 2 crítico). Métricas de expect_max: entry_cycle_ms,
+// exit_cycle_ms (subida a bajada del primer carril de cada tipo),
+// reader_wait_ms (espera de turno de un lector listo) y read_latency_ms
+// (primer paso con tarjeta a UID), peor caso entre todos los lectores, y
+// servo_accel_deg_s2 (mayor cambio de velocidad entre ticks de un servo).
+
+#ifndef SIM_TRACE_H
+#define SIM_TRACE_H
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+#include "config.h"
+
+struct TraceCommand
+{
+	uint32_t tMs;
+	std::string op;
+	std::vector<std::string> args;
+	int line; // línea de origen (0 si es sintética)
+};
+
+// Carga una traza de archivo; ordena por tiempo. false + error si falla
+bool loadTrace(const char *path, std::vector<TraceCommand> &out, std::string &error);
+
+// Genera un día de tráfico: llegadas aleatorias, paso por la pluma,
+// estadía en un cajón libre y salida. Determinista para una semilla.
+void generateSyntheticDay(int cars, uint32_t seed, std::vector<TraceCommand> &out);
+
+// Tráfico continuo para --serve: los mismos autos que el día sintético pero
+// a carsPerHour (tope 300/h) y con estadías cortas, generado por tramos
+class TrafficSource
+{
+public:
+	TrafficSource(uint32_t carsPerHour, uint32_t seed);
+	// Agrega los autos que llegan antes de untilMs y reordena out desde from
+	void fill(uint32_t untilMs, std::vector<TraceCommand> &out, size_t from);
+
+private:
+	uint32_t state;
+	uint32_t gapMs;
+	uint32_t nextArrival;
+	size_t cars = 0;
+	uint32_t slotFreeAt[SLOTS_COUNT] = {};
+};
+
+#endif // SIM_TRACE_H
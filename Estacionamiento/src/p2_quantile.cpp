@@ -0,0 +1,108 @@
+#include "p2_quantile.h"
+
+P2Quantile::P2Quantile(float p) : p(p)
+{
+	reset();
+}
+
+void P2Quantile::reset()
+{
+	total = 0;
+	for (int i = 0; i < 5; i++)
+	{
+		heights[i] = 0;
+		positions[i] = i;
+	}
+	desired[0] = 0;
+	desired[1] = 2 * p;
+	desired[2] = 4 * p;
+	desired[3] = 2 + 2 * p;
+	desired[4] = 4;
+	increments[0] = 0;
+	increments[1] = p / 2;
+	increments[2] = p;
+	increments[3] = (1 + p) / 2;
+	increments[4] = 1;
+}
+
+void P2Quantile::add(float x)
+{
+	if (total < 5)
+	{
+		// Primeras muestras: inserción ordenada en los marcadores
+		int i = (int)total;
+		while (i > 0 && heights[i - 1] > x)
+		{
+			heights[i] = heights[i - 1];
+			i--;
+		}
+		heights[i] = x;
+		total++;
+		return;
+	}
+
+	// Celda k donde cae la muestra; los extremos se amplían si hace falta
+	int k;
+	if (x < heights[0])
+	{
+		heights[0] = x;
+		k = 0;
+	}
+	else if (x >= heights[4])
+	{
+		heights[4] = x;
+		k = 3;
+	}
+	else
+	{
+		k = 0;
+		while (k < 3 && x >= heights[k + 1])
+			k++;
+	}
+	for (int i = k + 1; i < 5; i++)
+		positions[i]++;
+	for (int i = 0; i < 5; i++)
+		desired[i] += increments[i];
+	total++;
+
+	// Ajustar los marcadores interiores que se alejaron de su posición deseada
+	for (int i = 1; i < 4; i++)
+	{
+		float diff = desired[i] - positions[i];
+		if ((diff >= 1 && positions[i + 1] - positions[i] > 1) || (diff <= -1 && positions[i - 1] - positions[i] < -1))
+		{
+			int d = diff > 0 ? 1 : -1;
+			float h = parabolic(i, d);
+			if (!(heights[i - 1] < h && h < heights[i + 1]))
+				h = linear(i, d);
+			heights[i] = h;
+			positions[i] += d;
+		}
+	}
+}
+
+float P2Quantile::parabolic(int i, int d) const
+{
+	float n0 = positions[i - 1], n1 = positions[i], n2 = positions[i + 1];
+	return heights[i] + d / (n2 - n0) *
+							((n1 - n0 + d) * (heights[i + 1] - heights[i]) / (n2 - n1) +
+							 (n2 - n1 - d) * (heights[i] - heights[i - 1]) / (n1 - n0));
+}
+
+float P2Quantile::linear(int i, int d) const
+{
+	return heights[i] + d * (heights[i + d] - heights[i]) / (positions[i + d] - positions[i]);
+}
+
+float P2Quantile::value() const
+{
+	if (total == 0)
+		return 0;
+	if (total < 5)
+	{
+		// Cuantil exacto sobre las muestras ordenadas
+		int index = (int)(p * (total - 1) + 0.5f);
+		return heights[index];
+	}
+	return heights[2];
+}
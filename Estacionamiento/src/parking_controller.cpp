@@ -0,0 +1,514 @@
+#include "parking_controller.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <strings.h>
+
+const char *const AUTHORIZED_CARDS[AUTHORIZED_CARDS_COUNT] = AUTHORIZED_CARDS_LIST;
+
+static const uint8_t SLOT_SWITCH_PINS[SLOTS_COUNT] = {SWITCH_SLOT1, SWITCH_SLOT2};
+static const uint8_t SLOT_LED_PINS[SLOTS_COUNT] = {LED_RED_SLOT1, LED_RED_SLOT2};
+
+ParkingController::ParkingController(const ParkingHal &hal) : hal(hal)
+{
+	// Inicializar timestamps por cajón
+	for (int i = 0; i < SLOTS_COUNT; i++)
+	{
+		strcpy(entryTime[i], "--");
+		strcpy(exitTime[i], "--");
+	}
+	for (int i = 0; i < LANE_MAX; i++)
+		laneSession[i] = -1;
+}
+
+bool ParkingController::addLane(const LaneConfig &config, HalServo &servo, HalPulseCapture *detector,
+								HalRfidReader *reader)
+{
+	if (lanesUsed >= LANE_MAX)
+		return false;
+	lanes[lanesUsed].attach(config, servo, detector, reader);
+	if (config.kind == LANE_ENTRY && entryLane < 0)
+		entryLane = lanesUsed;
+	if (config.kind == LANE_EXIT && exitLane < 0)
+		exitLane = lanesUsed;
+	lanesUsed++;
+	return true;
+}
+
+void ParkingController::begin()
+{
+	// Sensores
+	for (int i = 0; i < SLOTS_COUNT; i++)
+		hal.gpio.pinMode(SLOT_SWITCH_PINS[i], HAL_INPUT_PULLUP);
+
+	// Actuadores: todas las plumas abajo (cada carril aplica su inversión)
+	uint32_t now = hal.clock.millis();
+	for (int i = 0; i < lanesUsed; i++)
+	{
+		lanes[i].begin(now);
+		if (lanes[i].reader())
+		{
+			rfidScheduler.add(*lanes[i].reader(), (uint8_t)i, now);
+			if (!lanes[i].isEntry())
+				exitByCard = true;
+		}
+	}
+	for (int i = 0; i < SLOTS_COUNT; i++)
+		hal.gpio.pinMode(SLOT_LED_PINS[i], HAL_OUTPUT);
+
+	applyParams();
+	// Mostrar estado inicial con contador de espacios disponibles
+	displayAvailableSlots();
+}
+
+void ParkingController::update()
+{
+	enterStage(STAGE_BARRIERS);
+	updateBarrierLogic();
+	enterStage(STAGE_DISPLAY);
+	updateDisplayLogic();
+	enterStage(STAGE_RFID);
+	checkRFID();
+	enterStage(STAGE_ULTRASONIC);
+	checkUltrasonicSensor();
+	enterStage(STAGE_SLOTS);
+	checkParkingSlots();
+	expireParkReservations(hal.clock.millis());
+	recordGateChanges();
+}
+
+uint32_t ParkingController::idleUntilMs(uint32_t nowMs) const
+{
+	if (deniedMessageActive || authorizedMessageActive || timeoutMessageActive)
+		return nowMs;
+	for (int i = 0; i < lanesUsed; i++)
+	{
+		if (!lanes[i].isIdle())
+			return nowMs;
+	}
+	uint32_t until = rfidScheduler.nextDueMs(nowMs);
+	for (int i = 0; i < SLOTS_COUNT; i++)
+	{
+		if (!parkReservations[i].active)
+			continue;
+		uint32_t expires = parkReservations[i].sinceMs + PARK_RESERVATION_TIMEOUT_MS;
+		if ((int32_t)(expires - until) < 0)
+			until = ((int32_t)(expires - nowMs) > 0) ? expires : nowMs;
+	}
+	return until;
+}
+
+// Una pluma sube con tarjetas, cajones o el ultrasónico y baja con el
+// servo: se registra el cambio al final del ciclo, venga de donde venga
+void ParkingController::recordGateChanges()
+{
+	for (int i = 0; i < lanesUsed; i++)
+	{
+		bool raised = lanes[i].isRaised();
+		if (raised == laneRaisedLogged[i])
+			continue;
+		laneRaisedLogged[i] = raised;
+		logEvent(EVT_GATE, (uint8_t)i, raised);
+	}
+}
+
+void ParkingController::enterStage(uint8_t stage)
+{
+	if (watchdog)
+		watchdog->enter(stage, hal.clock.millis());
+}
+
+// Evento para el collector (/api/events) y miga de pan para el watchdog
+void ParkingController::logEvent(uint8_t type, uint8_t index, uint8_t value)
+{
+	static const uint8_t CRUMB_OF_EVENT[EVT_TYPE_COUNT] = {CRUMB_SLOT, CRUMB_CARD, CRUMB_GATE};
+	uint32_t now = hal.clock.millis();
+	eventLog.record(type, index, value, now);
+	if (watchdog)
+		watchdog->note(CRUMB_OF_EVENT[type], index, value, now);
+}
+
+// El auto pasó la pluma con su reserva: queda a la espera del switch de un cajón
+void ParkingController::holdParkReservation(int session, uint32_t nowMs)
+{
+	for (int i = 0; i < SLOTS_COUNT; i++)
+	{
+		if (parkReservations[i].active)
+			continue;
+		parkReservations[i] = {nowMs, session, true};
+		return;
+	}
+}
+
+// Un switch consumió una reserva: no se sabe de qué auto, se descarta la más vieja
+void ParkingController::takeParkReservation(uint32_t nowMs)
+{
+	int oldest = -1;
+	for (int i = 0; i < SLOTS_COUNT; i++)
+	{
+		if (!parkReservations[i].active)
+			continue;
+		if (oldest < 0 || nowMs - parkReservations[i].sinceMs > nowMs - parkReservations[oldest].sinceMs)
+			oldest = i;
+	}
+	if (oldest >= 0)
+		parkReservations[oldest].active = false;
+}
+
+// La sesión sale sin haber estacionado: su reserva vuelve al inventario
+void ParkingController::releaseParkReservation(int session)
+{
+	for (int i = 0; i < SLOTS_COUNT; i++)
+	{
+		if (!parkReservations[i].active || parkReservations[i].session != session)
+			continue;
+		parkReservations[i].active = false;
+		inventory.release();
+		halLogf("Reserva devuelta: la sesión salió sin estacionar. Disponibles: %d\n", inventory.available());
+		return;
+	}
+}
+
+// Sensor que falla, auto que se da la vuelta o que entra detrás de otro:
+// la reserva no puede quedar tomada hasta el reinicio
+void ParkingController::expireParkReservations(uint32_t nowMs)
+{
+	for (int i = 0; i < SLOTS_COUNT; i++)
+	{
+		if (!parkReservations[i].active || nowMs - parkReservations[i].sinceMs < PARK_RESERVATION_TIMEOUT_MS)
+			continue;
+		parkReservations[i].active = false;
+		inventory.release();
+		halLogf("Reserva vencida sin ocupar cajón. Disponibles: %d\n", inventory.available());
+		if (!deniedMessageActive && !authorizedMessageActive && !timeoutMessageActive)
+			displayAvailableSlots();
+	}
+}
+
+int ParkingController::effectiveSalidaDelayMs() const
+{
+	return (autoTune && tuner.passage.ready()) ? tuner.passage.valueMs() : salidaDelayMs;
+}
+
+int ParkingController::effectiveUltrasonicTimeoutMs() const
+{
+	return (autoTune && tuner.approach.ready()) ? tuner.approach.valueMs() : ultrasonicTimeoutMs;
+}
+
+// Los valores manuales nunca se pisan: apagar AUTO_TUNE los vuelve a poner en uso
+void ParkingController::applyParams()
+{
+	for (int i = 0; i < lanesUsed; i++)
+		lanes[i].setTiming(effectiveUltrasonicTimeoutMs(), effectiveSalidaDelayMs());
+}
+
+void ParkingController::formatTime(char *buf)
+{
+	if (!hal.clock.formatWallTime(buf, TIME_TEXT_LEN))
+		strcpy(buf, "--");
+}
+
+// Un paso de lectura por ciclo: el planificador reparte el bus entre los lectores
+void ParkingController::checkRFID()
+{
+	char cardUID[UID_TEXT_LEN];
+	int lane = rfidScheduler.service(hal.clock, cardUID, sizeof(cardUID));
+	if (lane < 0)
+		return;
+	strcpy(lastUid, cardUID);
+	bool authorized = isCardAuthorized(cardUID);
+	logEvent(EVT_CARD, (uint8_t)lane, authorized);
+	if (!authorized)
+		handleUnauthorizedUser();
+	else if (lanes[lane].isEntry())
+		handleAuthorizedUser(lane, cardUID);
+	else
+		handleExitCard(lane, cardUID);
+}
+
+bool ParkingController::isCardAuthorized(const char *cardUID)
+{
+	for (int i = 0; i < AUTHORIZED_CARDS_COUNT; i++)
+	{
+		if (strcasecmp(cardUID, AUTHORIZED_CARDS[i]) == 0)
+			return true;
+	}
+	return false;
+}
+
+void ParkingController::handleAuthorizedUser(int lane, const char *cardUID)
+{
+	uint32_t now = hal.clock.millis();
+	int session = -1;
+	if (exitByCard)
+	{
+		// Anti-passback: la tarjeta ya tiene un auto adentro (salvo que sea
+		// la misma pasada de este carril, que se reinicia)
+		session = sessions.find(cardUID);
+		if (session >= 0 && session != laneSession[lane])
+		{
+			showTimedMessage(MSG_INSIDE_1, MSG_INSIDE_2);
+			return;
+		}
+	}
+	// Reservar un cajón antes de conceder acceso. Si este carril ya tiene una
+	// reserva sin usar (la pluma sigue esperando), se reutiliza.
+	if (!laneReserved[lane])
+	{
+		if (!inventory.tryReserve())
+		{
+			showTimedMessage(MSG_FULL_1, MSG_FULL_2);
+			return;
+		}
+		laneReserved[lane] = true;
+	}
+	if (exitByCard && session < 0)
+	{
+		// Si el carril esperaba a otra tarjeta, esa pasada se cancela
+		sessions.close(laneSession[lane]);
+		laneSession[lane] = sessions.open(cardUID, now);
+		if (laneSession[lane] < 0)
+		{
+			// Sin sesión el auto no podría salir con su tarjeta: no se admite
+			halLogf("[RFID] Tabla de sesiones llena (%d). Acceso rechazado en %s\n", SESSION_MAX, lanes[lane].name());
+			laneReserved[lane] = false;
+			inventory.release();
+			showTimedMessage(MSG_FULL_1, MSG_FULL_2);
+			return;
+		}
+	}
+
+	// La reserva se consume cuando el usuario confirma la ocupación
+	// presionando el switch del cajón, o se devuelve en el timeout.
+	halLogf("[RFID] Tarjeta válida en %s. Reservas: %d, disponibles: %d\n", lanes[lane].name(),
+			inventory.reservations(), inventory.available());
+	displayMessage(MSG_WELCOME_1, MSG_WELCOME_2);
+	lanes[lane].admit(now);
+	successMessageTimer.start(now);
+	authorizedMessageActive = true;
+}
+
+// Salida con lector: solo abre con una tarjeta que entró y sigue adentro
+void ParkingController::handleExitCard(int lane, const char *cardUID)
+{
+	uint32_t now = hal.clock.millis();
+	int session = sessions.find(cardUID);
+	if (session < 0)
+	{
+		halLogf("[RFID] %s sin sesión abierta en %s\n", cardUID, lanes[lane].name());
+		showTimedMessage(MSG_NO_SESSION_1, MSG_NO_SESSION_2);
+		return;
+	}
+	halLogf("[RFID] Salida de %s por %s tras %lu s\n", cardUID, lanes[lane].name(),
+			(unsigned long)((now - sessions.at(session).entryMs) / 1000));
+	releaseParkReservation(session);
+	sessions.close(session);
+	lanes[lane].open(now);
+	displayMessage(MSG_GOODBYE_1, MSG_GOODBYE_2);
+	successMessageTimer.start(now);
+	authorizedMessageActive = true;
+}
+
+void ParkingController::handleUnauthorizedUser()
+{
+	showTimedMessage(MSG_DENIED_1, MSG_DENIED_2);
+}
+
+// Mensaje de rechazo que se reemplaza por el contador tras DISPLAY_MESSAGE_MS
+void ParkingController::showTimedMessage(const char *line1, const char *line2)
+{
+	displayMessage(line1, line2);
+	displayMessageTimer.start(hal.clock.millis());
+	deniedMessageActive = true;
+}
+
+void ParkingController::checkUltrasonicSensor()
+{
+	uint32_t now = hal.clock.millis();
+	for (int i = 0; i < lanesUsed; i++)
+	{
+		if (!lanes[i].hasDetector())
+			continue;
+		uint8_t events = lanes[i].checkDetector(now);
+		if (events)
+			handleLaneEvents(i, events);
+	}
+}
+
+// Reacciones del controlador a lo que informa cada carril
+void ParkingController::handleLaneEvents(int lane, uint8_t events)
+{
+	Gate &gate = lanes[lane];
+	uint32_t now = hal.clock.millis();
+
+	if (events & GATE_EVT_SAMPLE)
+	{
+		// Guardar la lectura cruda en el historial (mm enteros)
+		distanceHistory.add(now, gate.filter().lastRawMm(), (uint8_t)lane);
+		laneDistance[lane] = gate.filter().filteredMm() / 10.0f;
+	}
+	if (events & GATE_EVT_DETECTED)
+	{
+		// El auto ya entró: su reserva queda a la espera del switch del cajón
+		// (con vencimiento) y su sesión abierta hasta que salga
+		if (laneReserved[lane])
+			holdParkReservation(laneSession[lane], now);
+		laneReserved[lane] = false;
+		laneSession[lane] = -1;
+		tuner.approach.add(gate.approachMs());
+		if (autoTune)
+			applyParams();
+	}
+	if ((events & GATE_EVT_PASSED) && gate.passageMeasured())
+	{
+		tuner.passage.add(gate.passageMs());
+		if (autoTune)
+			applyParams();
+	}
+	if (events & GATE_EVT_TIMEOUT)
+	{
+		// No se detectó auto: para el auto-ajuste es una aproximación sin medir
+		// (se cuenta aparte, no entra al cuantil), y el cajón reservado vuelve a estar libre
+		if (!gate.carSeen())
+			tuner.approach.addCensored();
+		if (laneReserved[lane])
+		{
+			laneReserved[lane] = false;
+			inventory.release();
+		}
+		sessions.close(laneSession[lane]);
+		laneSession[lane] = -1;
+		// Mostrar mensaje distinto cuando nunca se detectó el auto
+		displayMessage(MSG_TIMEOUT_1, MSG_TIMEOUT_2);
+		displayMessageTimer.start(now);
+		timeoutMessageActive = true;
+	}
+	if ((events & GATE_EVT_LOWERING) && gate.isEntry())
+	{
+		// Mostrar mensaje de paso y activar el flag para que se restaure luego
+		displayMessage(MSG_PASS_1, MSG_PASS_2);
+		authorizedMessageActive = true;
+		successMessageTimer.start(now);
+	}
+}
+
+// Abrir la primera pluma de salida libre; si todas están ocupadas, la
+// primera (que extiende su espera o vuelve a subir)
+void ParkingController::startExitSequence()
+{
+	int chosen = -1;
+	for (int i = 0; i < lanesUsed; i++)
+	{
+		if (lanes[i].isEntry())
+			continue;
+		if (chosen < 0)
+			chosen = i;
+		if (lanes[i].phase() == 0)
+		{
+			chosen = i;
+			break;
+		}
+	}
+	if (chosen >= 0)
+		lanes[chosen].open(hal.clock.millis());
+}
+
+void ParkingController::checkParkingSlots()
+{
+	for (int i = 0; i < SLOTS_COUNT; i++)
+	{
+		bool pressed = (hal.gpio.digitalRead(SLOT_SWITCH_PINS[i]) == HAL_LOW);
+		// Entrada al cajón (usuario acaba de estacionar)
+		if (pressed && !slotOccupied[i])
+		{
+			slotOccupied[i] = true;
+			updateLED(i, true);
+			// Registrar timestamp de entrada
+			formatTime(entryTime[i]);
+			// Consume una reserva pendiente o, si es una ocupación manual, un lugar libre
+			inventory.occupy();
+			takeParkReservation(hal.clock.millis());
+			logEvent(EVT_SLOT, (uint8_t)i, 1);
+			halLogf("Cajon %d - OCUPADO. Disponibles: %d\n", i + 1, inventory.available());
+			// Actualizar contador en pantalla si no hay mensajes temporales activos
+			if (!deniedMessageActive && !authorizedMessageActive && !timeoutMessageActive)
+			{
+				displayAvailableSlots();
+			}
+		}
+		// Salida del cajón (usuario marcó que desocupó)
+		else if (!pressed && slotOccupied[i])
+		{
+			slotOccupied[i] = false;
+			updateLED(i, false);
+			// Registrar timestamp de salida
+			formatTime(exitTime[i]);
+			inventory.vacate();
+			logEvent(EVT_SLOT, (uint8_t)i, 0);
+			halLogf("Cajon %d - DISPONIBLE. Disponibles: %d\n", i + 1, inventory.available());
+			// Actualizar contador en pantalla si no hay mensajes temporales activos
+			if (!deniedMessageActive && !authorizedMessageActive && !timeoutMessageActive)
+			{
+				displayAvailableSlots();
+			}
+			// Iniciar secuencia de salida que levanta la pluma y luego la baja
+			// (con lector de salida la abre la tarjeta, no el cajón)
+			if (!exitByCard)
+				startExitSequence();
+		}
+	}
+}
+
+void ParkingController::updateLED(int slot, bool occupied)
+{
+	hal.gpio.digitalWrite(SLOT_LED_PINS[slot], occupied ? HAL_HIGH : HAL_LOW);
+}
+
+void ParkingController::displayMessage(const char *line1, const char *line2)
+{
+	hal.display.showMessage(line1, line2);
+}
+
+// Cada carril avanza su máquina de estados con sus propios temporizadores
+void ParkingController::updateBarrierLogic()
+{
+	uint32_t now = hal.clock.millis();
+	for (int i = 0; i < lanesUsed; i++)
+	{
+		uint8_t events = lanes[i].update(now);
+		if (events)
+			handleLaneEvents(i, events);
+	}
+}
+
+void ParkingController::updateDisplayLogic()
+{
+	uint32_t now = hal.clock.millis();
+	if (deniedMessageActive && displayMessageTimer.update(now))
+	{
+		deniedMessageActive = false;
+		// Restaurar pantalla por defecto con contador
+		displayAvailableSlots();
+	}
+	if (authorizedMessageActive && successMessageTimer.update(now))
+	{
+		authorizedMessageActive = false;
+		// Restaurar pantalla por defecto con contador
+		displayAvailableSlots();
+	}
+	if (timeoutMessageActive && displayMessageTimer.update(now))
+	{
+		timeoutMessageActive = false;
+		// Restaurar pantalla por defecto con contador
+		displayAvailableSlots();
+	}
+}
+
+// Muestra en el OLED la cantidad de espacios disponibles cuando no hay mensajes
+void ParkingController::displayAvailableSlots()
+{
+	// Máximo 16 caracteres por línea
+	char line2[17];
+	snprintf(line2, sizeof(line2), "Disp: %d", inventory.available());
+	displayMessage(MSG_READY_1, line2);
+}
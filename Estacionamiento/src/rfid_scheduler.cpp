@@ -0,0 +1,93 @@
+#include "rfid_scheduler.h"
+
+bool RfidScheduler::add(HalRfidReader &reader, uint8_t lane, uint32_t nowMs)
+{
+	if (readerCount >= LANE_MAX)
+		return false;
+	Entry &e = readers[readerCount++];
+	e.reader = &reader;
+	e.lane = lane;
+	// Primera consulta tras RFID_COOLDOWN, como el temporizador de antes
+	e.dueMs = e.readyMs = nowMs + RFID_COOLDOWN;
+	e.addedMs = nowMs;
+	return true;
+}
+
+int RfidScheduler::service(HalClock &clock, char *uid, size_t len)
+{
+	uint32_t now = clock.millis();
+	for (int k = 0; k < readerCount; k++)
+	{
+		int i = (cursor + k) % readerCount;
+		Entry &e = readers[i];
+		if (!e.active && (int32_t)(now - e.dueMs) < 0)
+			continue;
+		cursor = (i + 1) % readerCount;
+
+		uint32_t waited = now - e.readyMs;
+		if ((int32_t)waited > 0 && waited > e.stats.waitMaxMs)
+			e.stats.waitMaxMs = waited;
+
+		uint32_t startUs = clock.micros();
+		uint8_t result = e.reader->poll(uid, len);
+		uint32_t stepUs = clock.micros() - startUs;
+		uint32_t end = clock.millis();
+		e.stats.polls++;
+		e.stats.pollTotalUs += stepUs;
+		if (stepUs > e.stats.pollMaxUs)
+			e.stats.pollMaxUs = stepUs;
+
+		if (result == RFID_PENDING)
+		{
+			if (!e.reading)
+				e.readStartMs = now;
+			e.active = true;
+			e.reading = true;
+		}
+		else if (result == RFID_CARD)
+		{
+			e.stats.read.add(end - (e.reading ? e.readStartMs : now));
+			e.stats.cards++;
+			// Falta el paso que cierra la transacción; la próxima lectura, tras el cooldown
+			e.active = true;
+			e.reading = false;
+			e.dueMs = now + RFID_COOLDOWN;
+		}
+		else
+		{
+			// Consulta en reposo o transacción abortada: esperar el periodo normal.
+			// Si se cerró una transacción con UID, dueMs ya quedó fijado
+			if (!e.active || e.reading)
+				e.dueMs = now + RFID_COOLDOWN;
+			e.active = false;
+			e.reading = false;
+		}
+		e.readyMs = e.active ? end : e.dueMs;
+		return (result == RFID_CARD) ? e.lane : -1;
+	}
+	return -1;
+}
+
+uint32_t RfidScheduler::nextDueMs(uint32_t nowMs) const
+{
+	// Sin lectores no hay límite (medio rango, para comparar con signo)
+	uint32_t wait = INT32_MAX;
+	for (int i = 0; i < readerCount; i++)
+	{
+		const Entry &e = readers[i];
+		int32_t left = (int32_t)(e.dueMs - nowMs);
+		if (e.active || left <= 0)
+			return nowMs;
+		if ((uint32_t)left < wait)
+			wait = (uint32_t)left;
+	}
+	return nowMs + wait;
+}
+
+uint32_t RfidScheduler::pollsPerMinute(int i, uint32_t nowMs) const
+{
+	uint32_t elapsed = nowMs - readers[i].addedMs;
+	if (elapsed == 0)
+		return 0;
+	return (uint32_t)((uint64_t)readers[i].stats.polls * 60000ULL / elapsed);
+}
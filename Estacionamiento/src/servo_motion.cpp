@@ -0,0 +1,171 @@
+#include "servo_motion.h"
+
+// Raíz cuadrada entera (método de Newton)
+static uint32_t isqrt(uint64_t v)
+{
+	if (v < 2)
+		return (uint32_t)v;
+	uint64_t x = v;
+	uint64_t y = (x + 1) / 2;
+	while (y < x)
+	{
+		x = y;
+		y = (x + v / x) / 2;
+	}
+	return (uint32_t)x;
+}
+
+ServoMotion::ServoMotion(uint16_t speedDegS, uint16_t accelDegS2)
+	: speed((int32_t)speedDegS * 100), accel((int32_t)accelDegS2 * 100)
+{
+	if (speed < 100)
+		speed = 100;
+	if (accel < 100)
+		accel = 100;
+}
+
+// Tiempo (ms) para cambiar la velocidad en dv, redondeado hacia arriba:
+// así ningún paso de 1 ms cambia la velocidad más que accel
+static uint32_t rampMs(int64_t dv, int32_t accel)
+{
+	return (uint32_t)((dv * 1000 + accel - 1) / accel);
+}
+
+void ServoMotion::setPosition(int angle)
+{
+	position = start = target = (int32_t)angle * 100;
+	velocity = 0;
+	moving = false;
+	arrived = false;
+	totalMs = 0;
+}
+
+void ServoMotion::moveTo(int angle, uint32_t nowMs)
+{
+	// Posición y velocidad en este instante (el timer puede no haber corrido)
+	update(nowMs);
+	int32_t v0 = velocity;
+	start = position;
+	target = (int32_t)angle * 100;
+	startMs = nowMs;
+	brakeSpeed = 0;
+	brakeMs = 0;
+	rampStart = start;
+	initialSpeed = 0;
+
+	int32_t distance = target - start;
+	int64_t stopDistance = (int64_t)v0 * v0 / (2 * (int64_t)accel);
+	if (v0 != 0 && ((int64_t)v0 * distance <= 0 || stopDistance > (distance < 0 ? -distance : distance)))
+	{
+		// Va en contra del destino o no alcanza a frenar antes: detenerse primero
+		brakeSpeed = v0;
+		brakeMs = rampMs(v0 < 0 ? -v0 : v0, accel);
+		int64_t speed0 = v0 < 0 ? -v0 : v0;
+		int64_t brakeTravel = speed0 * brakeMs / 1000 - (int64_t)accel * brakeMs * brakeMs / 2000000;
+		rampStart = start + (int32_t)(v0 < 0 ? -brakeTravel : brakeTravel);
+		distance = target - rampStart;
+	}
+	else if (v0 != 0)
+	{
+		// Sigue en el mismo sentido sin detenerse
+		initialSpeed = v0 < 0 ? -v0 : v0;
+	}
+	direction = distance < 0 ? -1 : 1;
+	if (distance < 0)
+		distance = -distance;
+	if (distance == 0 && initialSpeed == 0 && brakeMs == 0)
+	{
+		// Ya está en el destino: se informa la llegada igual
+		moving = false;
+		arrived = true;
+		totalMs = 0;
+		return;
+	}
+
+	// Distancia para ir de la velocidad inicial a la máxima y frenar desde ella
+	int64_t u2 = (int64_t)initialSpeed * initialSpeed;
+	int64_t rampDistance = ((int64_t)speed * speed - u2) / (2 * (int64_t)accel) + (int64_t)speed * speed / (2 * (int64_t)accel);
+	if (distance >= rampDistance)
+	{
+		// Trapecio: acelerar, crucero, frenar
+		peakSpeed = speed;
+		cruiseMs = (uint32_t)((int64_t)(distance - rampDistance) * 1000 / speed);
+	}
+	else
+	{
+		// Triángulo: no se alcanza la velocidad máxima
+		peakSpeed = (int32_t)isqrt(((uint64_t)2 * accel * distance + u2) / 2);
+		if (peakSpeed < initialSpeed)
+			peakSpeed = initialSpeed;
+		cruiseMs = 0;
+	}
+	accelMs = rampMs(peakSpeed - initialSpeed, accel);
+	decelMs = rampMs(peakSpeed, accel);
+	totalMs = brakeMs + accelMs + cruiseMs + decelMs;
+	moving = true;
+	arrived = false;
+}
+
+int32_t ServoMotion::update(uint32_t nowMs)
+{
+	if (!moving)
+		return position;
+	uint32_t t = nowMs - startMs;
+	if (t >= totalMs)
+	{
+		position = target;
+		velocity = 0;
+		moving = false;
+		arrived = true;
+		return position;
+	}
+
+	if (t < brakeMs)
+	{
+		// Frenado hasta detenerse
+		int64_t speed0 = brakeSpeed < 0 ? -brakeSpeed : brakeSpeed;
+		int64_t v = speed0 - (int64_t)accel * t / 1000;
+		int64_t travelled = speed0 * t / 1000 - (int64_t)accel * t * t / 2000000;
+		velocity = (int32_t)(brakeSpeed < 0 ? -v : v);
+		position = start + (int32_t)(brakeSpeed < 0 ? -travelled : travelled);
+		return position;
+	}
+	t -= brakeMs;
+
+	// Recorrido (centésimas de grado) desde el inicio del trapecio, según el tramo
+	int64_t travelled;
+	int64_t v;
+	if (t < accelMs)
+	{
+		v = initialSpeed + (int64_t)accel * t / 1000;
+		if (v > peakSpeed)
+			v = peakSpeed;
+		travelled = (int64_t)initialSpeed * t / 1000 + (int64_t)accel * t * t / 2000000;
+	}
+	else if (t < accelMs + cruiseMs)
+	{
+		v = peakSpeed;
+		int64_t rampTravel = ((int64_t)initialSpeed + peakSpeed) * accelMs / 2000;
+		travelled = rampTravel + (int64_t)peakSpeed * (t - accelMs) / 1000;
+	}
+	else
+	{
+		uint32_t remaining = totalMs - brakeMs - t;
+		v = (int64_t)accel * remaining / 1000;
+		if (v > peakSpeed)
+			v = peakSpeed;
+		int64_t full = (int64_t)(target > rampStart ? target - rampStart : rampStart - target);
+		travelled = full - (int64_t)accel * remaining * remaining / 2000000;
+	}
+	velocity = (int32_t)(direction * v);
+	position = rampStart + direction * (int32_t)travelled;
+	return position;
+}
+
+bool ServoMotion::takeArrived()
+{
+	if (!arrived)
+		return false;
+	arrived = false;
+	return true;
+}
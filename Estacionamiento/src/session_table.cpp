@@ -0,0 +1,45 @@
+#include "session_table.h"
+
+#include <stdio.h>
+#include <strings.h>
+
+int SessionTable::open(const char *uid, uint32_t nowMs)
+{
+	for (int i = 0; i < SESSION_MAX; i++)
+	{
+		if (sessions[i].open)
+			continue;
+		snprintf(sessions[i].uid, sizeof(sessions[i].uid), "%s", uid);
+		sessions[i].entryMs = nowMs;
+		sessions[i].open = true;
+		return i;
+	}
+	return -1;
+}
+
+int SessionTable::find(const char *uid) const
+{
+	for (int i = 0; i < SESSION_MAX; i++)
+	{
+		if (sessions[i].open && strcasecmp(sessions[i].uid, uid) == 0)
+			return i;
+	}
+	return -1;
+}
+
+void SessionTable::close(int i)
+{
+	if (i >= 0 && i < SESSION_MAX)
+		sessions[i].open = false;
+}
+
+int SessionTable::count() const
+{
+	int n = 0;
+	for (int i = 0; i < SESSION_MAX; i++)
+	{
+		if (sessions[i].open)
+			n++;
+	}
+	return n;
+}
@@ -0,0 +1,93 @@
+#include "ultrasonic_filter.h"
+
+UltrasonicFilter::UltrasonicFilter(uint8_t medianN, uint16_t alphaQ8, uint16_t enterMm, uint16_t exitMm)
+	: windowSize(medianN), alpha(alphaQ8), enterThresholdMm(enterMm), exitThresholdMm(exitMm)
+{
+	if (windowSize < 1)
+		windowSize = 1;
+	if (windowSize > ULTRASONIC_MEDIAN_MAX)
+		windowSize = ULTRASONIC_MEDIAN_MAX;
+	if (alpha < 1)
+		alpha = 1;
+	if (alpha > 256)
+		alpha = 256;
+	// La histéresis necesita EXIT >= ENTER
+	if (exitThresholdMm < enterThresholdMm)
+		exitThresholdMm = enterThresholdMm;
+	reset();
+}
+
+void UltrasonicFilter::reset()
+{
+	windowCount = 0;
+	windowHead = 0;
+	emaUsQ8 = 0;
+	primed = false;
+	isPresent = false;
+	rawMm = 0;
+}
+
+uint16_t UltrasonicFilter::echoToMm(uint32_t durationUs)
+{
+	uint32_t mm = durationUs * ULTRASONIC_MM_NUM / ULTRASONIC_MM_DEN;
+	return (mm > UINT16_MAX) ? UINT16_MAX : (uint16_t)mm;
+}
+
+uint32_t UltrasonicFilter::median() const
+{
+	// Ordenamiento por inserción sobre una copia (N <= 9)
+	uint32_t sorted[ULTRASONIC_MEDIAN_MAX];
+	for (uint8_t i = 0; i < windowCount; i++)
+	{
+		uint32_t v = window[i];
+		int8_t j = i - 1;
+		while (j >= 0 && sorted[j] > v)
+		{
+			sorted[j + 1] = sorted[j];
+			j--;
+		}
+		sorted[j + 1] = v;
+	}
+	return sorted[windowCount / 2];
+}
+
+bool UltrasonicFilter::addEcho(uint32_t durationUs)
+{
+	uint16_t mm = echoToMm(durationUs);
+	// pulseIn() devuelve 0 en timeout; también se descartan ecos fuera de rango
+	if (durationUs == 0 || mm < ULTRASONIC_MIN_MM || mm > ULTRASONIC_MAX_MM)
+		return false;
+	rawMm = mm;
+
+	window[windowHead] = durationUs;
+	windowHead = (windowHead + 1) % windowSize;
+	if (windowCount < windowSize)
+		windowCount++;
+
+	uint32_t med = median();
+	if (!primed)
+	{
+		emaUsQ8 = med << 8;
+		primed = true;
+	}
+	else
+	{
+		// ema += alpha * (x - ema), todo en Q8
+		int32_t diff = (int32_t)(med << 8) - (int32_t)emaUsQ8;
+		emaUsQ8 = (uint32_t)((int32_t)emaUsQ8 + (diff * (int32_t)alpha) / 256);
+	}
+
+	uint16_t filtered = filteredMm();
+	if (!isPresent && filtered < enterThresholdMm)
+		isPresent = true;
+	else if (isPresent && filtered > exitThresholdMm)
+		isPresent = false;
+	return true;
+}
+
+uint16_t UltrasonicFilter::filteredMm() const
+{
+	if (!primed)
+		return 0;
+	return echoToMm(emaUsQ8 >> 8);
+}